@@ -0,0 +1,90 @@
+#pragma once
+#include "HashMix.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// LRU-K 的访问历史：不保存 key 本身，每个条目是一个 uint64_t，高 56 位为 key 的指纹，低 8 位为访问次数（封顶 255）。
+// 表按 8 路组相联组织，一组正好一个缓存行；组内最近访问的条目排在最前面，组满时挤掉组内最久未访问的条目，
+// 近似于整个历史按 LRU 淘汰。记录与准入判断都只扫描一组。
+// 指纹冲突只会让两个 key 共用一个计数、影响准入时机，不影响缓存内容的正确性。不加锁，由调用方同步
+class AccessHistory
+{
+public:
+    explicit AccessHistory(size_t capacity)
+    {
+        size_t sets = 1;
+        while (sets * kWays < capacity) {
+            sets <<= 1;
+        }
+        table_.assign(sets * kWays, 0);
+        mask_ = sets - 1;
+    }
+
+    // 记录一次访问并移到组的最前面，返回记录后的访问次数
+    uint32_t record(uint64_t hash)
+    {
+        uint64_t h = mixHash(hash);
+        uint64_t* set = setOf(h);
+        uint64_t tag = tagOf(h);
+        size_t i = 0;
+        while (i < kWays && set[i] != 0 && (set[i] & ~kCountMask) != tag) {
+            ++i;
+        }
+        uint64_t count = 1;
+        if (i == kWays) {
+            i = kWays - 1;  // 组已满且没有找到，挤掉最后一个（组内最久未访问）
+        } else if (set[i] != 0) {
+            count = std::min<uint64_t>((set[i] & kCountMask) + 1, kCountMask);
+        }
+        for (; i > 0; --i) {
+            set[i] = set[i - 1];
+        }
+        set[0] = tag | count;
+        return static_cast<uint32_t>(count);
+    }
+
+    // 访问次数达到 k 时把条目从历史中移除并返回 true，判断与移除在同一次扫描中完成
+    bool admit(uint64_t hash, uint32_t k)
+    {
+        uint64_t h = mixHash(hash);
+        uint64_t* set = setOf(h);
+        uint64_t tag = tagOf(h);
+        for (size_t i = 0; i < kWays && set[i] != 0; ++i) {
+            if ((set[i] & ~kCountMask) != tag) {
+                continue;
+            }
+            if ((set[i] & kCountMask) < k) {
+                return false;
+            }
+            for (; i + 1 < kWays; ++i) {
+                set[i] = set[i + 1];
+            }
+            set[kWays - 1] = 0;
+            return true;
+        }
+        return false;
+    }
+
+    // 历史最多记录的 key 数（实际容量向上取整到 2 的幂组）
+    size_t capacity() const { return table_.size(); }
+
+    size_t memoryUsage() const { return table_.size() * sizeof(uint64_t); }
+
+private:
+    static constexpr size_t kWays = 8;
+    static constexpr uint64_t kCountMask = 0xff;
+
+    uint64_t* setOf(uint64_t h) { return &table_[static_cast<size_t>(h & mask_) * kWays]; }
+
+    // 0 表示空槽，指纹恰好为 0 时换成一个固定的非零值
+    static uint64_t tagOf(uint64_t h)
+    {
+        uint64_t tag = h & ~kCountMask;
+        return tag != 0 ? tag : (kCountMask + 1);
+    }
+
+    std::vector<uint64_t> table_;
+    size_t                mask_;
+};
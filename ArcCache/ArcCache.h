@@ -2,49 +2,74 @@
 #include "../Cachepolicy.h"
 #include "ArcLfuPart.h"
 #include "ArcLruPart.h"
+#include "../CacheBatch.h"
+#include "../CacheSnapshot.h"
+#include "../CacheWeigher.h"
+#include "../ShardRouter.h"
+#include "../SingleFlight.h"
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
-template<typename Key, typename Value>
+// LRU / LFU 两部分各自加锁的 ARC：get / put 可能在两部分中各查找一次，幽灵检查不在锁内，
+// 多线程下需由外层加锁（见 ArcHashCache）。单索引、一次探测且线程安全的版本见 UnifiedArcCache.h
+//
+// 内存：幽灵只有指纹，但没有命中幽灵的写入会同时进入 LRU 与 LFU 两部分，两部分的份额又各为 capacity，
+// 同一个条目可能在两部分各有一份结点和值，常驻内存最多约为同容量 LruCache 的两倍。
+// 需要内存接近同容量 LRU 时使用 UnifiedArcCache：每个 key 只常驻一份
+template<typename Key, typename Value, typename Index = StdIndex>
 class ArcCache : public CachePolicy<Key, Value>
 {
 public:
-    explicit ArcCache(size_t capacity = 10, size_t transformThreshold = 2)
+    // budget 非空时两个部分的条目计入共享的全局预算（见 ArcHashCache）；
+    // 设置 weigher 时 capacity 为权重上限，两个部分各自的份额都按权重计
+    explicit ArcCache(size_t capacity = 10, size_t transformThreshold = 2, ArcCapacityBudget* budget = nullptr,
+                      Weigher<Key, Value> weigher = nullptr)
         : capacity_(capacity)
         , transformThreshold_(transformThreshold)
-        , lfuPart_(std::make_unique<ArcLfuPart<Key, Value>>(capacity,transformThreshold))
-        , lruPart_(std::make_unique<ArcLruPart<Key, Value>>(capacity,transformThreshold))
+        , lfuPart_(std::make_unique<ArcLfuPart<Key, Value, Index>>(capacity, transformThreshold, budget, weigher,
+                                                                  &this->stats_))
+        , lruPart_(std::make_unique<ArcLruPart<Key, Value, Index>>(capacity, transformThreshold, budget, weigher,
+                                                                  &this->stats_))
     {}
 
     ~ArcCache() override = default;
 
     void put(Key key, Value value) override
     {
-        bool inGhost = checkGhostCache(key);
-        if (!inGhost)
-        {
-            if(lruPart_->put(key, value))
-            {
-                lfuPart_->put(key, value);
-            }
-        } else {
-            lruPart_->put(key, value);
-        }
+        putInternal(std::move(key), std::move(value), 0);
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        putInternal(std::move(key), std::move(value), expiryDeadline(ttl));
     }
 
     bool get(Key key, Value& value) override
     {
+        StatsTimer timer(this->stats_, CacheStats::Op::Get);
         checkGhostCache(key);
 
         bool shouldTransform = false;
-        if (lruPart_->get(key, value, shouldTransform)) 
+        uint64_t deadline = 0;
+        bool hit = false;
+        if (lruPart_->get(key, value, shouldTransform, deadline)) 
         {
             if (shouldTransform) 
             {
-                lfuPart_->put(key, value);
+                lfuPart_->put(key, value, deadline);
             }
-            return true;
+            hit = true;
+        }
+        else
+        {
+            hit = lfuPart_->get(key, value);
         }
-        return lfuPart_->get(key, value);
+        this->stats_.addConcurrent(hit ? CacheEvent::Hit : CacheEvent::Miss);
+        return hit;
     }
 
     Value get(Key key) override
@@ -53,23 +78,142 @@ public:
         get(key, value);
         return value;
     }
+
+    // ReadBufferedCache 记录访问用的句柄。两个部分的结点由 shared_ptr 管理、没有可复用的下标，
+    // 回放时要按 key 走 get 的完整路径，所以句柄就是 key 本身
+    using AccessToken = Key;
+
+    // 只读查找，不更新访问信息也不加锁；调用方需保证期间没有并发的修改（见 ReadBufferedCache）
+    bool peek(const Key& key, Value& value, AccessToken& token) const
+    {
+        if (!lruPart_->peek(key, value) && !lfuPart_->peek(key, value)) {
+            return false;
+        }
+        token = key;
+        return true;
+    }
+
+    // 回放一次访问，与 get 走同样的路径（包括幽灵命中的容量调整和向 LFU 部分的转移）
+    void touch(const Key& key)
+    {
+        Value value{};
+        get(key, value);
+    }
+
+    size_t purgeExpired() override { return lruPart_->purgeExpired() + lfuPart_->purgeExpired(); }
+
+    // 两个部分的条目数之和（同一个 key 可能同时在两部分中）
+    size_t size() override { return lruPart_->size() + lfuPart_->size(); }
+
+    size_t weightedSize() override { return lruPart_->weightedSize() + lfuPart_->weightedSize(); }
+
+    // 两个幽灵表中的指纹数（B1 + B2），幽灵不保存值
+    size_t ghostSize() { return lruPart_->ghostSize() + lfuPart_->ghostSize(); }
+
+    // 快照：总容量与 LRU 部分当前的份额（即自适应的划分），然后依次是两个部分的幽灵指纹与条目。
+    // 两部分份额之和恒为 2 * capacity
+    void saveTo(SnapshotWriter& out)
+    {
+        out.write(static_cast<uint32_t>(SnapshotKind::ArcGhostFingerprint));
+        out.write(static_cast<uint64_t>(capacity_));
+        out.write(static_cast<uint64_t>(lruPart_->capacity()));
+        lruPart_->saveTo(out);
+        lfuPart_->saveTo(out);
+    }
+
+    // 用快照替换当前内容。容量与保存时不同的话按比例换算 LRU 部分的份额；
+    // 数据不完整或类型不符时清空缓存并返回 false
+    bool loadFrom(SnapshotReader& in)
+    {
+        uint32_t kind;
+        uint64_t savedCapacity, savedLruCapacity;
+        if (!in.read(kind) ||
+            (kind != static_cast<uint32_t>(SnapshotKind::Arc) &&
+             kind != static_cast<uint32_t>(SnapshotKind::ArcGhostFingerprint)) ||
+            !in.read(savedCapacity) || !in.read(savedLruCapacity) || savedLruCapacity > 2 * savedCapacity)
+        {
+            lruPart_->clear();
+            lfuPart_->clear();
+            return false;
+        }
+        size_t lruCapacity = capacity_;
+        if (savedCapacity == capacity_)
+        {
+            lruCapacity = static_cast<size_t>(savedLruCapacity);
+        }
+        else if (savedCapacity > 0)
+        {
+            lruCapacity = std::min(2 * capacity_,
+                static_cast<size_t>(static_cast<double>(savedLruCapacity) / savedCapacity * capacity_));
+        }
+        bool ghostKeys = kind == static_cast<uint32_t>(SnapshotKind::Arc);
+        if (!lruPart_->loadFrom(in, lruCapacity, ghostKeys) ||
+            !lfuPart_->loadFrom(in, 2 * capacity_ - lruCapacity, ghostKeys))
+        {
+            lruPart_->clear();
+            lfuPart_->clear();
+            return false;
+        }
+        return true;
+    }
+
+    bool saveSnapshot(const std::string& path)
+    {
+        return saveSections(path, 1, [this](size_t, SnapshotWriter& out) { saveTo(out); });
+    }
+
+    bool loadSnapshot(const std::string& path)
+    {
+        return loadSections(path, 1, [this](size_t, SnapshotReader& in) { return loadFrom(in); });
+    }
 private:
+    // 两个部分中的同一个条目使用相同的过期刻度
+    // 同时写入两部分时 LRU 部分拿到副本，LFU 部分拿到参数本身
+    void putInternal(Key key, Value value, uint64_t deadline)
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        this->stats_.addConcurrent(CacheEvent::Put);
+        bool inGhost = checkGhostCache(key);
+        if (!inGhost)
+        {
+            if(lruPart_->put(key, value, deadline))
+            {
+                lfuPart_->put(std::move(key), std::move(value), deadline);
+            }
+        } else {
+            lruPart_->put(std::move(key), std::move(value), deadline);
+        }
+    }
+
+    // 幽灵命中时转移的容量：按条目计时为 1，按权重计时取当前条目的平均权重
+    size_t adaptStep()
+    {
+        size_t entries = size();
+        return entries == 0 ? 1 : std::max<size_t>(1, weightedSize() / entries);
+    }
+
     bool checkGhostCache(Key key)
     {
         bool inGhost = false;
         if (lruPart_->checkGhost(key)) 
         {
-            if (lfuPart_->decreaseCapacity()) 
+            this->stats_.addConcurrent(CacheEvent::GhostHit);
+            size_t step = adaptStep();
+            if (lfuPart_->decreaseCapacity(step)) 
             {
-                lruPart_->increaseCapacity();
+                lruPart_->increaseCapacity(step);
+                this->stats_.addConcurrent(CacheEvent::CapacityShift);
             }
             inGhost = true;
         } 
         else if (lfuPart_->checkGhost(key)) 
         {
-            if (lruPart_->decreaseCapacity()) 
+            this->stats_.addConcurrent(CacheEvent::GhostHit);
+            size_t step = adaptStep();
+            if (lruPart_->decreaseCapacity(step)) 
             {
-                lfuPart_->increaseCapacity();
+                lfuPart_->increaseCapacity(step);
+                this->stats_.addConcurrent(CacheEvent::CapacityShift);
             }
             inGhost = true;
         }
@@ -78,6 +222,194 @@ private:
 private:
     size_t capacity_;
     size_t transformThreshold_;
-    std::unique_ptr<ArcLruPart<Key, Value>> lruPart_;
-    std::unique_ptr<ArcLfuPart<Key, Value>> lfuPart_;
-};
\ No newline at end of file
+    std::unique_ptr<ArcLruPart<Key, Value, Index>> lruPart_;
+    std::unique_ptr<ArcLfuPart<Key, Value, Index>> lfuPart_;
+};
+
+// 分片的 ARC：每个分片是一个完整的 ArcCache（T1/T2/B1/B2 与自适应的分区目标都在分片内），
+// 分片上的一把锁覆盖整个操作，包括幽灵命中时两个部分之间的容量调整。
+// globalCapacity 为 true 时所有分片共享一份容量预算：分片超过自身 ceil(capacity/sliceNum) 份额后，
+// 只要全局用量未满就继续增长，热点分片因此可以借用冷分片空闲的容量。
+// 共享预算是软上限：份额以内的写入不看全局用量，借出的容量要等借用方下次写入时才归还。
+template<typename Key, typename Value, typename Index = StdIndex>
+class ArcHashCache
+{
+public:
+    ArcHashCache(size_t capacity, size_t sliceNum, size_t transformThreshold = 2, bool globalCapacity = false,
+                 Weigher<Key, Value> weigher = nullptr)
+        : capacity_(capacity)
+        , sliceNum_(sliceNum > 0 ? sliceNum : std::max<size_t>(1, std::thread::hardware_concurrency()))
+        , router_(sliceNum_)
+    {
+        size_t sliceSize = std::ceil(capacity / static_cast<double>(sliceNum_));
+        if (globalCapacity) {
+            // 每个 ARC 实例的 LRU、LFU 两部分各有 sliceSize 的份额，全局上限按同样的口径计算
+            budget_.reset(new ArcCapacityBudget(2 * sliceSize * sliceNum_));
+        }
+        for (size_t i = 0; i < sliceNum_; i++) {
+            arcHashCache_.emplace_back(new Slice(sliceSize, transformThreshold, budget_.get(), weigher));
+        }
+    }
+
+    void put(Key key, Value value)
+    {
+        Slice& slice = *arcHashCache_[router_.route(Hash(key))];
+        std::lock_guard<std::mutex> lock(slice.mutex);
+        slice.cache.put(std::move(key), std::move(value));
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl)
+    {
+        Slice& slice = *arcHashCache_[router_.route(Hash(key))];
+        std::lock_guard<std::mutex> lock(slice.mutex);
+        slice.cache.put(std::move(key), std::move(value), ttl);
+    }
+
+    bool get(Key key, Value& value)
+    {
+        Slice& slice = *arcHashCache_[router_.route(Hash(key))];
+        std::lock_guard<std::mutex> lock(slice.mutex);
+        return slice.cache.get(key, value);
+    }
+
+    Value get(Key key)
+    {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 批量接口：按分片分组后每个分片只加一次锁
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* found)
+    {
+        size_t hits = 0;
+        forEachShardGroup(keys, count,
+            [this](const Key& key) { return router_.route(Hash(key)); },
+            [&](size_t index, const uint32_t* positions, size_t n) {
+                Slice& slice = *arcHashCache_[index];
+                std::lock_guard<std::mutex> lock(slice.mutex);
+                for (size_t i = 0; i < n; ++i) {
+                    uint32_t pos = positions[i];
+                    found[pos] = slice.cache.get(keys[pos], values[pos]);
+                    hits += found[pos];
+                }
+            });
+        return hits;
+    }
+
+    void putMany(const Key* keys, const Value* values, size_t count)
+    {
+        forEachShardGroup(keys, count,
+            [this](const Key& key) { return router_.route(Hash(key)); },
+            [&](size_t index, const uint32_t* positions, size_t n) {
+                Slice& slice = *arcHashCache_[index];
+                std::lock_guard<std::mutex> lock(slice.mutex);
+                for (size_t i = 0; i < n; ++i) {
+                    slice.cache.put(keys[positions[i]], values[positions[i]]);
+                }
+            });
+    }
+
+    // 各分片依次加锁求和，结果不是某一时刻的精确快照
+    size_t size()
+    {
+        size_t total = 0;
+        for (auto& slice : arcHashCache_) {
+            std::lock_guard<std::mutex> lock(slice->mutex);
+            total += slice->cache.size();
+        }
+        return total;
+    }
+
+    size_t weightedSize()
+    {
+        size_t total = 0;
+        for (auto& slice : arcHashCache_) {
+            std::lock_guard<std::mutex> lock(slice->mutex);
+            total += slice->cache.weightedSize();
+        }
+        return total;
+    }
+
+    // 逐个分片回收过期条目，同一时刻只持有一个分片的锁
+    size_t purgeExpired()
+    {
+        size_t total = 0;
+        for (auto& slice : arcHashCache_) {
+            std::lock_guard<std::mutex> lock(slice->mutex);
+            total += slice->cache.purgeExpired();
+        }
+        return total;
+    }
+
+    // 每个分片一个 section，多个线程并行编码 / 解码，每个线程同一时刻只持有一个分片的锁。
+    // 分片数或路由不同时 key 到分片的映射也不同，拒绝加载
+    bool saveSnapshot(const std::string& path)
+    {
+        return saveSections(path, sliceNum_, [this](size_t i, SnapshotWriter& out) {
+            std::lock_guard<std::mutex> lock(arcHashCache_[i]->mutex);
+            arcHashCache_[i]->cache.saveTo(out);
+        }, router_.snapshotLayout());
+    }
+
+    bool loadSnapshot(const std::string& path)
+    {
+        return loadSections(path, sliceNum_, [this](size_t i, SnapshotReader& in) {
+            std::lock_guard<std::mutex> lock(arcHashCache_[i]->mutex);
+            return arcHashCache_[i]->cache.loadFrom(in);
+        }, router_.snapshotLayout());
+    }
+
+    // 读穿透：未命中时由 loader(key, value) 加载并写回，同一 key 的并发未命中只调用一次 loader，
+    // loader 在分片锁之外执行。语义见 SingleFlight.h
+    template<typename Loader>
+    LoadStatus getOrLoad(const Key& key, Value& value, Loader&& loader,
+                         std::chrono::milliseconds timeout = SingleFlight<Key, Value>::kNoTimeout)
+    {
+        return flights_.getOrLoad(*this, key, value, std::forward<Loader>(loader), timeout);
+    }
+
+    uint64_t coalescedWaiters() const { return flights_.coalescedWaiters(); }
+
+    // 各分片统计之和；每个分片的计数各自读取，不是某一时刻的精确快照
+    CacheStatsSnapshot stats()
+    {
+        CacheStatsSnapshot total;
+        for (auto& slice : arcHashCache_) {
+            total += slice->cache.stats();
+        }
+        return total;
+    }
+
+    void setStatsSampling(uint32_t every)
+    {
+        for (auto& slice : arcHashCache_) {
+            slice->cache.setStatsSampling(every);
+        }
+    }
+
+public:
+    size_t Hash(const Key& key) {
+        std::hash<Key> hashFunc;
+        return hashFunc(key);
+    }
+
+private:
+    struct Slice
+    {
+        Slice(size_t capacity, size_t transformThreshold, ArcCapacityBudget* budget, Weigher<Key, Value> weigher)
+            : cache(capacity, transformThreshold, budget, std::move(weigher))
+        {}
+
+        std::mutex            mutex;
+        ArcCache<Key, Value, Index>  cache;
+    };
+
+private:
+    size_t                                capacity_;
+    size_t                                sliceNum_;
+    MixRouter                             router_;      // 混合哈希值后选择分片，见 ShardRouter.h
+    std::unique_ptr<ArcCapacityBudget>    budget_;      // 需在分片之前构造、之后析构
+    std::vector<std::unique_ptr<Slice>>   arcHashCache_;
+    SingleFlight<Key, Value>              flights_;
+};
@@ -1,7 +1,26 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <memory>
 
+#include "../TimerWheel.h"
+
+template<typename Key, typename Value> struct ArcFreqBucket;
+
+// 多个 ARC 实例共享的容量预算：各部分插入/淘汰时按条目权重增减 used（未设置 weigher 时即条目数），
+// 超出自身份额的部分只有在全局用量达到 limit 时才需要在本地淘汰
+struct ArcCapacityBudget
+{
+    std::atomic<size_t> used{0};
+    size_t              limit;
+
+    explicit ArcCapacityBudget(size_t limit) : limit(limit) {}
+
+    // 再放入 incoming 的权重是否会超出全局上限
+    bool exhausted(size_t incoming) const { return used.load(std::memory_order_relaxed) + incoming > limit; }
+};
+
 template<typename Key, typename Value>
 class ArcNode
 {
@@ -11,25 +30,29 @@ private:
     size_t accessCount_;
     std::shared_ptr<ArcNode>prev_;
     std::shared_ptr<ArcNode>next_;
+    ArcFreqBucket<Key, Value>* bucket_; // LFU 部分中结点所在的频次桶
+    uint32_t timer_;                    // 所在部分时间轮上的过期定时器，没有过期时间时为 kNone
 
 public:
-    ArcNode() : accessCount_(1), prev_(nullptr), next_(nullptr) {}
+    ArcNode() : accessCount_(1), prev_(nullptr), next_(nullptr), bucket_(nullptr), timer_(TimerWheel<Key>::kNone) {}
     ArcNode(Key key, Value value)
-        : key_(key)
-        , value_(value)
+        : key_(std::move(key))
+        , value_(std::move(value))
         , accessCount_(1)
         , prev_(nullptr)
         , next_(nullptr)
+        , bucket_(nullptr)
+        , timer_(TimerWheel<Key>::kNone)
     {}
 
     Key getKey() const {return key_;}
     Value getValue() const {return value_;}
     size_t getAccessCount() const {return accessCount_;}
 
-    void set_Value(Value value) {value_ = value;}
+    void set_Value(Value value) {value_ = std::move(value);}
     void increaseAccessCount() {++accessCount_;}
 
-    template<typename k, typename v> friend class ArcLruPart;
-    template<typename k, typename v> friend class ArcLfuPart;
+    template<typename k, typename v, typename i> friend class ArcLruPart;
+    template<typename k, typename v, typename i> friend class ArcLfuPart;
 
 };
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../FlatHashMap.h"
+#include "../HashMix.h"
+
+// key 的 64 位幽灵指纹，0 留作空槽
+template<typename Key>
+uint64_t ghostFingerprint(const Key& key)
+{
+    uint64_t fp = mixHash(static_cast<uint64_t>(LookupHash<Key>()(key)));
+    return fp != 0 ? fp : 1;
+}
+
+// ARC 的幽灵表（B1 / B2）：只记录被淘汰 key 的指纹，值在淘汰时就已释放。
+// 指纹按进入顺序存放在环形数组里，另用一张扁平哈希表从指纹找到它在环中的位置；
+// 幽灵命中时环中的槽位只置空，等环的起点走过它时再回收，因此每个幽灵固定占用约 20 字节。
+// 幽灵按进入顺序老化：环满时挤掉最早进入的一个，被命中而置空的槽位也照常占着环中的位置。
+// 环按需倍增到 capacity，内存只随实际的幽灵数增长。capacity 按条目数计，所属的部分按自身的条目数
+// （按权重计容量时由份额与平均权重换算）设置并随份额调整。不加锁，由所属的 ARC 部分同步
+class ArcGhostIndex
+{
+public:
+    explicit ArcGhostIndex(size_t capacity)
+        : capacity_(capacity)
+        , head_(0)
+        , used_(0)
+    {}
+
+    // 记录一个刚被淘汰的 key；已经在表中时移到最新的位置
+    void add(uint64_t fp)
+    {
+        if (capacity_ == 0) {
+            return;
+        }
+        remove(fp);
+        while (index_.size() >= capacity_) {
+            dropOldest();   // 上限调小之后环可能比上限大
+        }
+        if (used_ == ring_.size()) {
+            if (ring_.size() < capacity_) {
+                grow();
+            } else {
+                dropOldest();
+            }
+        }
+        size_t pos = head_ + used_;
+        if (pos >= ring_.size()) {
+            pos -= ring_.size();
+        }
+        ring_[pos] = fp;
+        index_.emplace(fp, static_cast<uint32_t>(pos));
+        ++used_;
+    }
+
+    // 幽灵命中：找到时移除并返回 true
+    bool remove(uint64_t fp)
+    {
+        auto it = index_.find(fp);
+        if (it == index_.end()) {
+            return false;
+        }
+        ring_[it->second] = 0;
+        index_.erase(fp);
+        return true;
+    }
+
+    bool contains(uint64_t fp) const { return index_.find(fp) != index_.end(); }
+
+    size_t size() const { return index_.size(); }
+    size_t capacity() const { return capacity_; }
+
+    // 调整上限，缩小时按进入顺序丢弃最早的指纹；环比上限大出很多时整理成小的环，释放多余的内存
+    void setCapacity(size_t capacity)
+    {
+        capacity_ = capacity;
+        while (index_.size() > capacity_) {
+            dropOldest();
+        }
+        if (ring_.size() > 2 * capacity_ + 16) {
+            rebuild(std::max(index_.size(), std::min<size_t>(capacity_, 16)));
+        }
+    }
+
+    void clear()
+    {
+        std::fill(ring_.begin(), ring_.end(), 0);
+        index_.clear();
+        head_ = 0;
+        used_ = 0;
+    }
+
+    // 从最早进入到最新依次调用 fn(fp)，供快照使用
+    template<typename Fn>
+    void forEach(Fn&& fn) const
+    {
+        for (size_t i = 0, pos = head_; i < used_; ++i) {
+            if (ring_[pos] != 0) {
+                fn(ring_[pos]);
+            }
+            if (++pos == ring_.size()) {
+                pos = 0;
+            }
+        }
+    }
+
+private:
+    void grow() { rebuild(std::min(capacity_, std::max<size_t>(16, 2 * ring_.size()))); }
+
+    // 按进入顺序拷贝到 size 个槽位的数组中，环的起点回到 0；size 不小于现有的指纹数
+    void rebuild(size_t size)
+    {
+        std::vector<uint64_t> ring;
+        ring.reserve(size);
+        forEach([&ring](uint64_t fp) { ring.push_back(fp); });
+        index_.clear();
+        for (size_t i = 0; i < ring.size(); ++i) {
+            index_.emplace(ring[i], static_cast<uint32_t>(i));
+        }
+        used_ = ring.size();
+        head_ = 0;
+        ring.resize(size, 0);
+        ring_.swap(ring);
+    }
+
+    void dropOldest()
+    {
+        if (ring_[head_] != 0) {
+            index_.erase(ring_[head_]);
+            ring_[head_] = 0;
+        }
+        if (++head_ == ring_.size()) {
+            head_ = 0;
+        }
+        --used_;
+    }
+
+    size_t                             capacity_;
+    std::vector<uint64_t>              ring_;    // 按进入顺序排列的指纹，0 为空槽
+    FlatHashMap<uint64_t, uint32_t>    index_;   // 指纹 -> 在 ring_ 中的下标
+    size_t                             head_;    // 最早进入的槽位
+    size_t                             used_;    // head_ 起被占用（含已置空）的槽位数
+};
@@ -1,206 +1,608 @@
 #pragma once
 
 #include "ArcCacheNode.h"
+#include "ArcGhostIndex.h"
+#include "../FlatHashMap.h"
+#include "../CacheSnapshot.h"
+#include "../CacheStats.h"
+#include "../CacheWeigher.h"
 #include <memory>
 #include <unordered_map>
-#include <map>
+#include <vector>
 #include <mutex>
-#include <list>
 
+// 频次桶：同一访问频次的结点通过结点自身的 prev_/next_ 串成侵入式链表，
+// 桶之间按频次升序互相链接，最小频次桶就是哨兵的后继
 template<typename Key, typename Value>
+struct ArcFreqBucket
+{
+    using NodePtr = std::shared_ptr<ArcNode<Key, Value>>;
+
+    size_t         freq = 0;
+    NodePtr        head;
+    NodePtr        tail;
+    ArcFreqBucket* prev = nullptr;
+    ArcFreqBucket* next = nullptr;
+
+    bool empty() const { return head == nullptr; }
+};
+
+template<typename Key, typename Value, typename Index = StdIndex>
 class ArcLfuPart
 {
 public:
     using NodeType = ArcNode<Key, Value>;
     using NodePtr = std::shared_ptr<NodeType>;
-    using NodeMap = std::unordered_map<Key, NodePtr>;
-    using FreqMap = std::map<size_t, std::list<NodePtr>>;
+    using NodeMap = typename Index::template Map<Key, NodePtr>;
+    using Bucket = ArcFreqBucket<Key, Value>;
+    using WeigherType = Weigher<Key, Value>;
 
-    explicit ArcLfuPart(size_t capacity, size_t transformThreshold)
+    explicit ArcLfuPart(size_t capacity, size_t transformThreshold, ArcCapacityBudget* budget = nullptr,
+                        WeigherType weigher = nullptr, CacheStats* stats = nullptr)
         : capacity_(capacity)
-        , ghostCapacity_(capacity)
+        , baseCapacity_(capacity)
         , transformThreshold_(transformThreshold)
-        , minFreq_(0)
+        , budget_(budget)
+        , weigher_(std::move(weigher))
+        , stats_(stats)
+        , weightedSize_(0)
+        , freeBuckets_(nullptr)
+        , ghosts_(weigher_ ? 0 : capacity)
     {
         initializeLists();
     }
 
-    bool put(Key key, Value value) 
+    ~ArcLfuPart()
+    {
+        unlinkAll();
+    }
+
+    // deadline 为过期刻度（见 TimerWheel.h），0 表示不过期
+    bool put(Key key, Value value, uint64_t deadline = 0) 
     {
         if (capacity_ == 0)
             return false;
 
         std::lock_guard<std::mutex>lock(mutex_);
+        expireLocked();
+        NodePtr node;
         auto it = mainCache_.find(key);
         if (it != mainCache_.end())
         {
-            return updateExistingNode(it->second, value);
+            node = it->second;
+            if (!updateExistingNode(node, std::move(value)))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            node = addNewNode(std::move(key), std::move(value));
+            if (!node)
+            {
+                return false;
+            }
         }
-        return addNewNode(key, value);
+        setExpiry(node, deadline);
+        return true;
     }
 
     bool get(Key key, Value& value) 
     {
         std::lock_guard<std::mutex>lock(mutex_);
         auto it = mainCache_.find(key);
-        if (it != mainCache_.end())
+        if (it == mainCache_.end())
         {
-            updateNodeFrequency(it->second);
-            value = it->second->getValue();
-            return true;
+            return false;
         }
-        return false;
+        NodePtr node = it->second;
+        if (wheel_.expired(node->timer_))
+        {
+            removeExpired(node);
+            record(CacheEvent::Expiration);
+            return false;
+        }
+        updateNodeFrequency(node);
+        value = node->getValue();
+        return true;
     }
 
-    bool checkGhost(Key key) 
+    bool peek(const Key& key, Value& value) const
     {
-        auto it = ghostCache_.find(key);
-        if (it != ghostCache_.end())
+        auto it = mainCache_.find(key);
+        if (it == mainCache_.end() || wheel_.expired(it->second->timer_))
         {
-            removeFromGhost(it->second);
-            ghostCache_.erase(it);
-            return true;
+            return false;
         }
-        return false;
+        value = it->second->getValue();
+        return true;
     }
 
-    void increaseCapacity() { ++capacity_; }
+    // 幽灵命中时移除该幽灵并返回 true
+    bool checkGhost(Key key) 
+    {
+        return ghosts_.remove(ghostFingerprint(key));
+    }
 
-    bool decreaseCapacity() 
+    size_t ghostSize() const { return ghosts_.size(); }
+
+    // 幽灵命中时两部分之间转移的容量，step 为一个条目的（平均）权重
+    void increaseCapacity(size_t step = 1)
     {
-        if (capacity_ <= 0)
+        capacity_ += step;
+        ghosts_.setCapacity(ghostLimit());
+    }
+
+    bool decreaseCapacity(size_t step = 1) 
+    {
+        if (capacity_ < step || capacity_ == 0)
             return false;
 
-        if (mainCache_.size() >= capacity_)
+        while (overCapacity(step) && !mainCache_.empty())
         {
             evictLeastFrequent();
         }
-        --capacity_;
+        capacity_ -= step;
+        ghosts_.setCapacity(ghostLimit());
+        return true;
+    }
+
+    size_t purgeExpired()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return expireLocked();
+    }
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return mainCache_.size();
+    }
+
+    size_t weightedSize()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return weightedSize_;
+    }
+
+    size_t capacity()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clearLocked();
+    }
+
+    // 快照：幽灵指纹从旧到新，然后是条目 (key, value, 剩余存活时间, 频次)，
+    // 按频次桶升序、桶内从旧到新
+    void saveTo(SnapshotWriter& out)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out.write(static_cast<uint64_t>(ghosts_.size()));
+        ghosts_.forEach([&out](uint64_t fp) { out.write(fp); });
+
+        size_t countAt = out.reserve(sizeof(uint64_t));
+        uint64_t count = 0;
+        uint64_t now = expiryNow();
+        for (Bucket* bucket = freqHead_.next; bucket != &freqHead_; bucket = bucket->next)
+        {
+            for (NodePtr node = bucket->head; node; node = node->next_)
+            {
+                uint64_t remaining;
+                if (!snapshotRemaining(node->timer_ == TimerWheel<Key>::kNone ? 0 : wheel_.deadline(node->timer_),
+                                       now, remaining))
+                {
+                    continue;
+                }
+                out.write(node->key_);
+                out.write(node->value_);
+                out.write(remaining);
+                out.write(static_cast<uint64_t>(bucket->freq));
+                ++count;
+            }
+        }
+        out.patch(countAt, &count, sizeof(count));
+    }
+
+    // 用快照替换当前内容，capacity 为恢复后的份额；ghostKeys 的含义见 ArcLruPart::loadFrom。
+    // 数据不完整时清空并返回 false
+    bool loadFrom(SnapshotReader& in, size_t capacity, bool ghostKeys = false)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clearLocked();
+        capacity_ = capacity;
+        baseCapacity_ = capacity;
+
+        uint64_t ghosts;
+        if (!in.read(ghosts))
+        {
+            return false;
+        }
+        std::vector<uint64_t> savedGhosts;
+        for (uint64_t i = 0; i < ghosts; ++i)
+        {
+            uint64_t fp;
+            if (!readGhost(in, ghostKeys, fp))
+            {
+                clearLocked();
+                return false;
+            }
+            savedGhosts.push_back(fp);
+        }
+
+        uint64_t count;
+        if (!in.read(count))
+        {
+            clearLocked();
+            return false;
+        }
+        mainCache_.reserve(static_cast<size_t>(std::min<uint64_t>(count, capacity_)));
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            Key key;
+            Value value;
+            uint64_t remaining, freq;
+            if (!in.read(key) || !in.read(value) || !in.read(remaining) || !in.read(freq) ||
+                mainCache_.find(key) != mainCache_.end())
+            {
+                clearLocked();
+                return false;
+            }
+            restoreEntry(key, value, snapshotDeadline(remaining), static_cast<size_t>(std::max<uint64_t>(freq, 1)));
+        }
+        restoreGhosts(savedGhosts);
         return true;
     }
 
-    
 private:
+    // 幽灵表的上限（条目数），换算方式见 ArcLruPart::ghostLimit
+    size_t ghostLimit() const
+    {
+        size_t share = std::max(capacity_, baseCapacity_);
+        if (!weigher_)
+        {
+            return share;
+        }
+        if (mainCache_.empty())
+        {
+            return ghosts_.capacity();
+        }
+        size_t avgWeight = std::max<size_t>(1, weightedSize_ / mainCache_.size());
+        return std::max(mainCache_.size(), share / avgWeight);
+    }
+
+    // 做法见 ArcLruPart::restoreGhosts
+    void restoreGhosts(const std::vector<uint64_t>& saved)
+    {
+        std::vector<uint64_t> evicted;
+        ghosts_.forEach([&evicted](uint64_t fp) { evicted.push_back(fp); });
+        ghosts_.clear();
+        ghosts_.setCapacity(ghostLimit());
+        for (uint64_t fp : saved)
+        {
+            ghosts_.add(fp);
+        }
+        for (uint64_t fp : evicted)
+        {
+            ghosts_.add(fp);
+        }
+    }
+
+    // 断开结点之间的 shared_ptr 环，避免丢弃时泄漏
+    void unlinkAll()
+    {
+        for (auto& entry : mainCache_) {
+            entry.second->prev_.reset();
+            entry.second->next_.reset();
+        }
+    }
+
+    static bool readGhost(SnapshotReader& in, bool ghostKeys, uint64_t& fp)
+    {
+        if (!ghostKeys)
+        {
+            return in.read(fp);
+        }
+        Key key;
+        if (!in.read(key))
+        {
+            return false;
+        }
+        fp = ghostFingerprint(key);
+        return true;
+    }
+
+    void clearLocked()
+    {
+        unlinkAll();
+        mainCache_.clear();
+        ghosts_.clear();
+        wheel_.clear();
+        bucketStore_.clear();
+        freeBuckets_ = nullptr;
+        subWeight(weightedSize_);
+        initializeLists();
+    }
+
+    // 按快照中的频次插入：快照按频次升序写出，通常直接追加到最后一个桶
+    void restoreEntry(const Key& key, const Value& value, uint64_t deadline, size_t freq)
+    {
+        size_t weight = weighEntry(weigher_, key, value);
+        if (weight > capacity_)
+        {
+            return;
+        }
+        while (overCapacity(weight) && !mainCache_.empty())
+        {
+            evictLeastFrequent();
+        }
+
+        NodePtr node = std::make_shared<NodeType>(key, value);
+        node->accessCount_ = freq;
+        mainCache_[key] = node;
+
+        Bucket* pos = freqHead_.prev;
+        while (pos != &freqHead_ && pos->freq > freq)
+        {
+            pos = pos->prev;
+        }
+        if (pos == &freqHead_ || pos->freq != freq)
+        {
+            pos = insertBucketAfter(pos, freq);
+        }
+        appendToBucket(pos, node);
+        addWeight(weight);
+        setExpiry(node, deadline);
+    }
+
+    // 两个部分各有自己的锁，可能被不同线程同时修改，统计按并发路径记录
+    void record(CacheEvent event, uint64_t n = 1)
+    {
+        if (stats_ && n > 0)
+        {
+            stats_->addConcurrent(event, n);
+        }
+    }
+
+    // 再放入 incoming 的权重会超出自身份额，且（没有全局预算或全局预算已用完）时需要淘汰
+    bool overCapacity(size_t incoming) const
+    {
+        return weightedSize_ + incoming > capacity_ && (!budget_ || budget_->exhausted(incoming));
+    }
+
     void initializeLists() 
     {
-        ghostHead_ = std::make_shared<NodeType>();
-        ghostTail_ = std::make_shared<NodeType>();
-        ghostHead_->next_ = ghostTail_;
-        ghostTail_->prev_ = ghostHead_;
+        freqHead_.prev = &freqHead_;
+        freqHead_.next = &freqHead_;
     }
 
-    bool updateExistingNode(NodePtr node, const Value& value) 
+    size_t weightOf(const NodePtr& node) const { return weighEntry(weigher_, node->key_, node->value_); }
+
+    void setExpiry(const NodePtr& node, uint64_t deadline)
     {
-        node->set_Value(value);
+        if (deadline == 0)
+        {
+            wheel_.cancel(node->timer_);
+            node->timer_ = TimerWheel<Key>::kNone;
+        }
+        else
+        {
+            node->timer_ = wheel_.reschedule(node->timer_, node->key_, deadline);
+        }
+    }
+
+    size_t expireLocked()
+    {
+        if (wheel_.empty())
+        {
+            return 0;
+        }
+        size_t expired = wheel_.advance(expiryNow(), [this](const Key& key) {
+            auto it = mainCache_.find(key);
+            if (it != mainCache_.end())
+            {
+                NodePtr node = it->second;
+                node->timer_ = TimerWheel<Key>::kNone;
+                removeExpired(node);
+            }
+        });
+        record(CacheEvent::Expiration, expired);
+        return expired;
+    }
+
+    // 过期的条目不是因容量被淘汰的，不进入幽灵链表
+    void removeExpired(const NodePtr& node)
+    {
+        unlinkFromBucket(node);
+        subWeight(weightOf(node));
+        wheel_.cancel(node->timer_);
+        node->timer_ = TimerWheel<Key>::kNone;
+        mainCache_.erase(node->getKey());
+    }
+
+    void addWeight(size_t weight)
+    {
+        weightedSize_ += weight;
+        if (budget_) budget_->used.fetch_add(weight, std::memory_order_relaxed);
+    }
+
+    void subWeight(size_t weight)
+    {
+        weightedSize_ -= weight;
+        if (budget_) budget_->used.fetch_sub(weight, std::memory_order_relaxed);
+    }
+
+    bool updateExistingNode(NodePtr node, Value value) 
+    {
+        size_t oldWeight = weightOf(node);
+        node->set_Value(std::move(value));
+        size_t newWeight = weightOf(node);
+        addWeight(newWeight);
+        subWeight(oldWeight);
+        if (newWeight > capacity_)
+        {
+            // 单个条目就超过容量：直接移除，不进入幽灵链表
+            unlinkFromBucket(node);
+            wheel_.cancel(node->timer_);
+            node->timer_ = TimerWheel<Key>::kNone;
+            mainCache_.erase(node->getKey());
+            subWeight(newWeight);
+            return false;
+        }
         updateNodeFrequency(node);
-        return true;
+        while (overCapacity(0) && !mainCache_.empty())
+        {
+            evictLeastFrequent();
+        }
+        // 被更新的结点自己也可能因频次最低而被淘汰
+        return node->bucket_ != nullptr;
     }
 
-    bool addNewNode(const Key& key, const Value& value) 
+    NodePtr addNewNode(Key key, Value value) 
     {
-        if (mainCache_.size() >= capacity_)
+        size_t weight = weighEntry(weigher_, key, value);
+        if (weight > capacity_)
+        {
+            return nullptr;
+        }
+        while (overCapacity(weight) && !mainCache_.empty())
         {
             evictLeastFrequent();
         }
 
-        NodePtr newnode = std::make_shared<NodeType>(key, value);
-        mainCache_[key] = newnode;
+        NodePtr newnode = std::make_shared<NodeType>(key, std::move(value));
+        mainCache_.emplace(std::move(key), newnode);
 
-        if (freqMap_.find(1) == freqMap_.end())
+        Bucket* first = freqHead_.next;
+        if (first == &freqHead_ || first->freq != 1)
         {
-            freqMap_[1] = std::list<NodePtr>();
+            first = insertBucketAfter(&freqHead_, 1);
         }
-        freqMap_[1].push_back(newnode);
-        minFreq_ = 1;
+        appendToBucket(first, newnode);
+        addWeight(weight);
 
-        return true;
+        return newnode;
     }
 
+    // 结点移动到相邻的下一个频次桶，全程 O(1)
     void updateNodeFrequency(NodePtr node) 
     {
-        size_t oldFreq = node->getAccessCount();
+        Bucket* oldBucket = node->bucket_;
         node->increaseAccessCount();
         size_t newFreq = node->getAccessCount();
 
-        auto& oldList = freqMap_[oldFreq];
-        oldList.remove(node);
-        if (oldList.empty())
+        Bucket* newBucket = oldBucket->next;
+        if (newBucket == &freqHead_ || newBucket->freq != newFreq)
         {
-            freqMap_.erase(oldFreq);
-            if (oldFreq == minFreq_)
-                minFreq_ = newFreq;
+            newBucket = insertBucketAfter(oldBucket, newFreq);
         }
 
-        if (freqMap_.find(newFreq) == freqMap_.end())
-        {
-            freqMap_[newFreq] = std::list<NodePtr>();
-        }
-        freqMap_[newFreq].push_back(node);
+        unlinkFromBucket(node);
+        appendToBucket(newBucket, node);
     }
 
     void evictLeastFrequent()
     {
-        if (freqMap_.empty())
+        Bucket* minBucket = freqHead_.next;
+        if (minBucket == &freqHead_)
             return;
+        ghosts_.setCapacity(ghostLimit());
 
-        auto& minFreqList = freqMap_[minFreq_];
-        if (minFreqList.empty())
-            return;
+        NodePtr leastNode = minBucket->head;
+        unlinkFromBucket(leastNode);
+        subWeight(weightOf(leastNode));
+        wheel_.cancel(leastNode->timer_);
+        leastNode->timer_ = TimerWheel<Key>::kNone;
 
-        NodePtr leastNode = minFreqList.front();
-        minFreqList.pop_front();
+        // 幽灵表只记指纹，结点连同值随着从索引中删除而释放
+        ghosts_.add(ghostFingerprint(leastNode->key_));
+        mainCache_.erase(leastNode->key_);
+        record(CacheEvent::Eviction);
+    }
 
-        if(minFreqList.empty())
+    Bucket* insertBucketAfter(Bucket* pos, size_t freq)
+    {
+        Bucket* bucket = freeBuckets_;
+        if (bucket)
         {
-            freqMap_.erase(minFreq_);
-            if (!freqMap_.empty())
-            {
-                minFreq_ = freqMap_.begin()->first;
-            }
+            freeBuckets_ = bucket->next;
         }
-
-        if (ghostCache_.size() >= ghostCapacity_)
+        else
         {
-            removeOldestGhost();
+            bucketStore_.emplace_back(new Bucket());
+            bucket = bucketStore_.back().get();
         }
-        addToGhost(leastNode);
-        mainCache_.erase(leastNode->getKey());
+        bucket->freq = freq;
+        bucket->prev = pos;
+        bucket->next = pos->next;
+        pos->next->prev = bucket;
+        pos->next = bucket;
+        return bucket;
     }
 
-    void removeFromGhost(NodePtr node)
+    // 空桶从频次链表上摘下，放回空闲链表复用
+    void releaseBucket(Bucket* bucket)
     {
-        node->prev_->next_ = node->next_;
-        node->next_->prev_ = node->prev_;
+        bucket->prev->next = bucket->next;
+        bucket->next->prev = bucket->prev;
+        bucket->prev = nullptr;
+        bucket->next = freeBuckets_;
+        freeBuckets_ = bucket;
     }
 
-    void addToGhost(NodePtr node)
+    void appendToBucket(Bucket* bucket, NodePtr node)
     {
-        node->next_ = ghostTail_;
-        node->prev_ = ghostTail_->prev_;
-        ghostTail_->prev_->next_ = node;
-        ghostTail_->prev_ = node;
+        node->bucket_ = bucket;
+        node->prev_ = bucket->tail;
+        node->next_ = nullptr;
+        if (bucket->tail)
+            bucket->tail->next_ = node;
+        else
+            bucket->head = node;
+        bucket->tail = node;
     }
 
-    void removeOldestGhost() 
+    void unlinkFromBucket(NodePtr node)
     {
-        NodePtr oldestGhost = ghostHead_->next_;
-        if (oldestGhost != ghostTail_) {
-            removeFromGhost(oldestGhost);
-            ghostCache_.erase(oldestGhost->getKey());
+        Bucket* bucket = node->bucket_;
+        if (node->prev_)
+            node->prev_->next_ = node->next_;
+        else
+            bucket->head = node->next_;
+        if (node->next_)
+            node->next_->prev_ = node->prev_;
+        else
+            bucket->tail = node->prev_;
+        node->prev_.reset();
+        node->next_.reset();
+        node->bucket_ = nullptr;
+
+        if (bucket->empty())
+        {
+            releaseBucket(bucket);
         }
     }
+
 private:
     size_t capacity_;
-    size_t ghostCapacity_;
+    size_t baseCapacity_;     // 构造或恢复快照时的份额
     size_t transformThreshold_;
-    size_t minFreq_;
+    ArcCapacityBudget* budget_;
+    WeigherType weigher_;
+    CacheStats* stats_;       // 所属 ArcCache 的统计，可以为空
+    size_t weightedSize_;
     std::mutex mutex_;
 
     NodeMap mainCache_;
-    NodeMap ghostCache_;
-    FreqMap freqMap_;
-    
-    NodePtr ghostHead_;
-    NodePtr ghostTail_;
 
+    Bucket freqHead_;                                 // 频次桶链表的哨兵
+    Bucket* freeBuckets_;                             // 可复用的空桶
+    std::vector<std::unique_ptr<Bucket>> bucketStore_; // 所有桶的所有权
+    ArcGhostIndex ghosts_;                            // B2：被淘汰 key 的指纹
+
+    TimerWheel<Key> wheel_;   // 设置了过期时间的条目
 };
\ No newline at end of file
@@ -1,105 +1,445 @@
 #pragma once
 
 #include "ArcCacheNode.h"
+#include "ArcGhostIndex.h"
+#include "../FlatHashMap.h"
+#include "../CacheSnapshot.h"
+#include "../CacheStats.h"
+#include "../CacheWeigher.h"
 #include <unordered_map>
+#include <vector>
 #include <mutex>
 
-template<typename Key, typename Value>
+template<typename Key, typename Value, typename Index = StdIndex>
 class ArcLruPart
 {
 public:
     using NodeType =  ArcNode<Key, Value>;
     using NodePtr  =  std::shared_ptr<NodeType>;
-    using NodeMap  =  std::unordered_map<Key, NodePtr>;
+    using NodeMap  = typename Index::template Map<Key, NodePtr>;
+    using WeigherType = Weigher<Key, Value>;
 
-    explicit ArcLruPart(size_t capacity, size_t transformThreashold)
+    explicit ArcLruPart(size_t capacity, size_t transformThreashold, ArcCapacityBudget* budget = nullptr,
+                        WeigherType weigher = nullptr, CacheStats* stats = nullptr)
         : capacity_(capacity)
-        , ghostCapacity_(capacity)
+        , baseCapacity_(capacity)
         , transformThreashold_(transformThreashold)
+        , budget_(budget)
+        , weigher_(std::move(weigher))
+        , stats_(stats)
+        , weightedSize_(0)
+        , ghosts_(weigher_ ? 0 : capacity)
     {
         initializeLists();
     }
 
-    bool put(Key key, Value value) 
+    ~ArcLruPart()
+    {
+        unlinkAll();
+    }
+
+    // deadline 为过期刻度（见 TimerWheel.h），0 表示不过期
+    bool put(Key key, Value value, uint64_t deadline = 0) 
     {
         if (capacity_ == 0) return false;
 
         std::lock_guard<std::mutex> lock(mutex_);
+        expireLocked();
+        NodePtr node;
         auto it = mainCache_.find(key);
         if (it != mainCache_.end())
         {
-            return updateExsitingNode(it->second, value);
+            node = it->second;
+            if (!updateExsitingNode(node, std::move(value)))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            node = addNewNode(std::move(key), std::move(value));
+            if (!node)
+            {
+                return false;
+            }
         }
-        return addNewNode(key, value);
+        setExpiry(node, deadline);
+        return true;
     }
 
-    bool get(Key key, Value& value, bool& shouldTransform) 
+    // deadline 返回条目的过期刻度，供转移到 LFU 部分时沿用
+    bool get(Key key, Value& value, bool& shouldTransform, uint64_t& deadline) 
     {
         std::lock_guard<std::mutex> lock(mutex_);
         auto it = mainCache_.find(key);
-        if (it != mainCache_.end()) 
+        if (it == mainCache_.end()) 
+        {
+            return false;
+        }
+        NodePtr node = it->second;
+        if (wheel_.expired(node->timer_))
         {
-            shouldTransform = updateNodeAccess(it->second);
-            value = it->second->getValue();
-            return true;
+            removeExpired(node);
+            record(CacheEvent::Expiration);
+            return false;
         }
-        return false;
+        shouldTransform = updateNodeAccess(node);
+        value = node->getValue();
+        deadline = node->timer_ == TimerWheel<Key>::kNone ? 0 : wheel_.deadline(node->timer_);
+        return true;
     }
 
-    bool checkGhost(Key key) 
+    bool peek(const Key& key, Value& value) const
     {
-        auto it = ghostCache_.find(key);
-        if (it != ghostCache_.end()) {
-            removeFromGhost(it->second);
-            ghostCache_.erase(it);
-            return true;
+        auto it = mainCache_.find(key);
+        if (it == mainCache_.end() || wheel_.expired(it->second->timer_))
+        {
+            return false;
         }
-        return false;
+        value = it->second->getValue();
+        return true;
     }
 
-    void increaseCapacity() { ++capacity_; }
+    // 幽灵命中时移除该幽灵并返回 true
+    bool checkGhost(Key key) 
+    {
+        return ghosts_.remove(ghostFingerprint(key));
+    }
+
+    size_t ghostSize() const { return ghosts_.size(); }
+
+    // 幽灵命中时两部分之间转移的容量，step 为一个条目的（平均）权重
+    void increaseCapacity(size_t step = 1)
+    {
+        capacity_ += step;
+        ghosts_.setCapacity(ghostLimit());
+    }
     
-    bool decreaseCapacity() 
+    bool decreaseCapacity(size_t step = 1) 
     {
-        if (capacity_ <= 0) return false;
-        if (mainCache_.size() == capacity_) {
+        if (capacity_ < step || capacity_ == 0) return false;
+        while (overCapacity(step) && !mainCache_.empty()) {
             evictLeastRecent();
         }
-        --capacity_;
+        capacity_ -= step;
+        ghosts_.setCapacity(ghostLimit());
+        return true;
+    }
+
+    size_t purgeExpired()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return expireLocked();
+    }
+
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return mainCache_.size();
+    }
+
+    size_t weightedSize()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return weightedSize_;
+    }
+
+    size_t capacity()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clearLocked();
+    }
+
+    // 快照：幽灵指纹从旧到新，然后是条目 (key, value, 剩余存活时间, 访问次数)，从最久未访问到最近访问
+    void saveTo(SnapshotWriter& out)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t countAt = out.reserve(sizeof(uint64_t));
+        uint64_t count = 0;
+        ghosts_.forEach([&](uint64_t fp) {
+            out.write(fp);
+            ++count;
+        });
+        out.patch(countAt, &count, sizeof(count));
+
+        countAt = out.reserve(sizeof(uint64_t));
+        count = 0;
+        uint64_t now = expiryNow();
+        for (NodePtr node = mainTail_->prev_; node != mainHead_; node = node->prev_)
+        {
+            uint64_t remaining;
+            if (!snapshotRemaining(node->timer_ == TimerWheel<Key>::kNone ? 0 : wheel_.deadline(node->timer_),
+                                   now, remaining))
+            {
+                continue;
+            }
+            out.write(node->key_);
+            out.write(node->value_);
+            out.write(remaining);
+            out.write(static_cast<uint64_t>(node->accessCount_));
+            ++count;
+        }
+        out.patch(countAt, &count, sizeof(count));
+    }
+
+    // 用快照替换当前内容，capacity 为恢复后的份额（由 ArcCache 按保存时的划分换算）。
+    // 先读出幽灵，再按从旧到新的顺序插入条目，份额不够时被挤出的条目照常进入幽灵表；
+    // 读出的幽灵最后排在这些被挤出的条目之前放回，总数按恢复后的 ghostLimit() 截断。
+    // ghostKeys 为 true 时快照中的幽灵是完整的 key（旧格式），读出后换算成指纹。数据不完整时清空并返回 false
+    bool loadFrom(SnapshotReader& in, size_t capacity, bool ghostKeys = false)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clearLocked();
+        capacity_ = capacity;
+        baseCapacity_ = capacity;
+
+        uint64_t ghosts;
+        if (!in.read(ghosts))
+        {
+            return false;
+        }
+        std::vector<uint64_t> savedGhosts;
+        for (uint64_t i = 0; i < ghosts; ++i)
+        {
+            uint64_t fp;
+            if (!readGhost(in, ghostKeys, fp))
+            {
+                clearLocked();
+                return false;
+            }
+            savedGhosts.push_back(fp);
+        }
+
+        uint64_t count;
+        if (!in.read(count))
+        {
+            clearLocked();
+            return false;
+        }
+        mainCache_.reserve(static_cast<size_t>(std::min<uint64_t>(count, capacity_)));
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            Key key;
+            Value value;
+            uint64_t remaining, accessCount;
+            if (!in.read(key) || !in.read(value) || !in.read(remaining) || !in.read(accessCount) ||
+                mainCache_.find(key) != mainCache_.end())
+            {
+                clearLocked();
+                return false;
+            }
+            NodePtr node = addNewNode(std::move(key), std::move(value));
+            if (node)
+            {
+                node->accessCount_ = static_cast<size_t>(std::max<uint64_t>(accessCount, 1));
+                setExpiry(node, snapshotDeadline(remaining));
+            }
+        }
+        restoreGhosts(savedGhosts);
         return true;
     }
 
 private:
+    // 幽灵表的上限（条目数）。不按权重计时就是份额，按权重计时把份额按驻留条目的平均权重换算成条目数，
+    // 且不少于驻留的条目数；部分为空、无从估计平均权重时沿用原来的上限。
+    // 份额取当前值与初始划分中的较大者：份额被调到很小时幽灵表仍能留住足够的历史，让份额有机会调回来
+    size_t ghostLimit() const
+    {
+        size_t share = std::max(capacity_, baseCapacity_);
+        if (!weigher_)
+        {
+            return share;
+        }
+        if (mainCache_.empty())
+        {
+            return ghosts_.capacity();
+        }
+        size_t avgWeight = std::max<size_t>(1, weightedSize_ / mainCache_.size());
+        return std::max(mainCache_.size(), share / avgWeight);
+    }
+
+    // 快照中的幽灵早于恢复条目时被挤出的幽灵，按先旧后新的顺序重新加入；上限按恢复后的条目换算，
+    // 快照中的幽灵再多也只留下最新的 ghostLimit() 个
+    void restoreGhosts(const std::vector<uint64_t>& saved)
+    {
+        std::vector<uint64_t> evicted;
+        ghosts_.forEach([&evicted](uint64_t fp) { evicted.push_back(fp); });
+        ghosts_.clear();
+        ghosts_.setCapacity(ghostLimit());
+        for (uint64_t fp : saved)
+        {
+            ghosts_.add(fp);
+        }
+        for (uint64_t fp : evicted)
+        {
+            ghosts_.add(fp);
+        }
+    }
+
+    // 链表结点之间互相持有 shared_ptr，丢弃前先断开
+    void unlinkAll()
+    {
+        for (NodePtr node = mainHead_; node; )
+        {
+            NodePtr next = node->next_;
+            node->prev_.reset();
+            node->next_.reset();
+            node = next;
+        }
+    }
+
+    static bool readGhost(SnapshotReader& in, bool ghostKeys, uint64_t& fp)
+    {
+        if (!ghostKeys)
+        {
+            return in.read(fp);
+        }
+        Key key;
+        if (!in.read(key))
+        {
+            return false;
+        }
+        fp = ghostFingerprint(key);
+        return true;
+    }
+
+    void clearLocked()
+    {
+        unlinkAll();
+        mainCache_.clear();
+        ghosts_.clear();
+        wheel_.clear();
+        subWeight(weightedSize_);
+        initializeLists();
+    }
+
+    // 两个部分各有自己的锁，可能被不同线程同时修改，统计按并发路径记录
+    void record(CacheEvent event, uint64_t n = 1)
+    {
+        if (stats_ && n > 0)
+        {
+            stats_->addConcurrent(event, n);
+        }
+    }
+
+    // 再放入 incoming 的权重会超出自身份额，且（没有全局预算或全局预算已用完）时需要淘汰
+    bool overCapacity(size_t incoming) const
+    {
+        return weightedSize_ + incoming > capacity_ && (!budget_ || budget_->exhausted(incoming));
+    }
+
     void initializeLists() 
     {
         mainHead_ = std::make_shared<NodeType>();
         mainTail_ = std::make_shared<NodeType>();
         mainHead_->next_ = mainTail_;
         mainTail_->prev_ = mainHead_;
+    }
 
-        ghostHead_ = std::make_shared<NodeType>();
-        ghostTail_ = std::make_shared<NodeType>();
-        ghostHead_->next_ = ghostTail_;
-        ghostTail_->prev_ = ghostHead_;
+    size_t weightOf(const NodePtr& node) const { return weighEntry(weigher_, node->key_, node->value_); }
+
+    void setExpiry(const NodePtr& node, uint64_t deadline)
+    {
+        if (deadline == 0)
+        {
+            wheel_.cancel(node->timer_);
+            node->timer_ = TimerWheel<Key>::kNone;
+        }
+        else
+        {
+            node->timer_ = wheel_.reschedule(node->timer_, node->key_, deadline);
+        }
     }
 
-    bool updateExsitingNode(NodePtr node, const Value& value)
+    size_t expireLocked()
     {
-        node->set_Value(value);
+        if (wheel_.empty())
+        {
+            return 0;
+        }
+        size_t expired = wheel_.advance(expiryNow(), [this](const Key& key) {
+            auto it = mainCache_.find(key);
+            if (it != mainCache_.end())
+            {
+                NodePtr node = it->second;
+                node->timer_ = TimerWheel<Key>::kNone;
+                removeExpired(node);
+            }
+        });
+        record(CacheEvent::Expiration, expired);
+        return expired;
+    }
+
+    // 过期的条目不是因容量被淘汰的，不进入幽灵链表，以免干扰两部分之间的容量调整
+    void removeExpired(const NodePtr& node)
+    {
+        removeFromMain(node);
+        subWeight(weightOf(node));
+        wheel_.cancel(node->timer_);
+        node->timer_ = TimerWheel<Key>::kNone;
+        mainCache_.erase(node->getKey());
+    }
+
+    bool updateExsitingNode(NodePtr node, Value value)
+    {
+        size_t oldWeight = weightOf(node);
+        node->set_Value(std::move(value));
+        size_t newWeight = weightOf(node);
+        addWeight(newWeight);
+        subWeight(oldWeight);
+        if (newWeight > capacity_)
+        {
+            // 单个条目就超过容量：直接移除，不进入幽灵链表
+            removeFromMain(node);
+            wheel_.cancel(node->timer_);
+            node->timer_ = TimerWheel<Key>::kNone;
+            mainCache_.erase(node->getKey());
+            subWeight(newWeight);
+            return false;
+        }
         movetoFront(node);
+        while (overCapacity(0) && mainCache_.size() > 1)
+        {
+            evictLeastRecent();
+        }
         return true;
     }
 
-    bool addNewNode(const Key& key, const Value& value)
+    NodePtr addNewNode(Key key, Value value)
     {
-        if (mainCache_.size() >= capacity_)
+        size_t weight = weighEntry(weigher_, key, value);
+        if (weight > capacity_)
+        {
+            return nullptr;
+        }
+        while (overCapacity(weight) && !mainCache_.empty())
         {
             evictLeastRecent();
         }
-        NodePtr newNode = std::make_shared<NodeType>(key, value);
-        mainCache_[key] = newNode;
+        // key 在结点和索引中各存一份：先复制进结点，再把参数本身移动进索引
+        NodePtr newNode = std::make_shared<NodeType>(key, std::move(value));
+        mainCache_.emplace(std::move(key), newNode);
         addToFront(newNode);
-        return true;
+        addWeight(weight);
+        return newNode;
+    }
+
+    void addWeight(size_t weight)
+    {
+        weightedSize_ += weight;
+        if (budget_) budget_->used.fetch_add(weight, std::memory_order_relaxed);
+    }
+
+    void subWeight(size_t weight)
+    {
+        weightedSize_ -= weight;
+        if (budget_) budget_->used.fetch_sub(weight, std::memory_order_relaxed);
     }
 
     bool updateNodeAccess(NodePtr node) 
@@ -130,16 +470,17 @@ private:
         NodePtr leastRecent = mainTail_->prev_;
         if (leastRecent == mainHead_) 
             return;
+        ghosts_.setCapacity(ghostLimit());   // 上限随平均权重变化，在结点仍计入时换算
 
         removeFromMain(leastRecent);
+        subWeight(weightOf(leastRecent));
+        wheel_.cancel(leastRecent->timer_);
+        leastRecent->timer_ = TimerWheel<Key>::kNone;
 
-        if (ghostCache_.size() >= ghostCapacity_)
-        {
-            removeOldestGhost();
-        }
-        addtoGhost(leastRecent);
-        
-        mainCache_.erase(leastRecent->getKey());
+        // 幽灵表只记指纹，结点连同值随着从索引中删除而释放
+        ghosts_.add(ghostFingerprint(leastRecent->key_));
+        mainCache_.erase(leastRecent->key_);
+        record(CacheEvent::Eviction);
     }
 
     void removeFromMain(NodePtr node)
@@ -148,47 +489,21 @@ private:
         node->next_->prev_ = node->prev_;
     }
 
-    void removeFromGhost(NodePtr node)
-    {
-        node->prev_->next_ = node->next_;
-        node->next_->prev_ = node->prev_;
-    }
-
-    void addtoGhost(NodePtr node)
-    {
-        node->accessCount_ = 1;
-
-        node->next_ = ghostHead_->next_;
-        node->prev_ = ghostHead_;
-        ghostHead_->next_->prev_ = node;
-        ghostHead_->next_ = node;
-
-        ghostCache_[node->getKey()] = node;
-    }
-
-    void removeOldestGhost()
-    {
-        NodePtr oldestGhost = ghostTail_->prev_;
-        if (oldestGhost == ghostHead_)
-            return;
-        
-        removeFromGhost(oldestGhost);
-        ghostCache_.erase(oldestGhost->getKey());
-    }
-
-
 private:
     size_t capacity_;
-    size_t ghostCapacity_;
+    size_t baseCapacity_;     // 构造或恢复快照时的份额，幽灵表上限的下限
     size_t transformThreashold_;
+    ArcCapacityBudget* budget_;
+    WeigherType weigher_;
+    CacheStats* stats_;       // 所属 ArcCache 的统计，可以为空
+    size_t weightedSize_;
     std::mutex mutex_;
 
     NodeMap mainCache_;
-    NodeMap ghostCache_;
 
     NodePtr mainHead_;
     NodePtr mainTail_;
+    ArcGhostIndex ghosts_;   // B1：被淘汰 key 的指纹
 
-    NodePtr ghostHead_;
-    NodePtr ghostTail_;
+    TimerWheel<Key> wheel_;   // 设置了过期时间的条目
 };
\ No newline at end of file
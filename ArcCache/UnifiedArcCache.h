@@ -0,0 +1,553 @@
+#pragma once
+#include "../Cachepolicy.h"
+#include "../CacheSnapshot.h"
+#include "../CacheWeigher.h"
+#include "../FlatHashMap.h"
+#include "../NodePool.h"
+#include "../TimerWheel.h"
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+
+// 条目所在的 ARC 链表：T1 / T2 为常驻条目（只访问过一次 / 至少两次），B1 / B2 为对应的幽灵
+enum class ArcList : uint8_t { T1 = 0, T2 = 1, B1 = 2, B2 = 3 };
+
+template<typename Key, typename Value, typename Index> class UnifiedArcCache;
+
+template<typename Key, typename Value>
+class UnifiedArcNode
+{
+private:
+    Key      key_;
+    Value    value_;    // 幽灵不保存值，降级时释放（见 releaseValue）
+    size_t   weight_;   // 降级为幽灵时保留，幽灵命中时按它调整分区目标
+    uint32_t prev_;
+    uint32_t next_;
+    uint32_t timer_;    // 过期定时器，幽灵与没有过期时间的条目为 kNone
+    ArcList  list_;
+
+public:
+    UnifiedArcNode(Key key, Value value)
+        : key_(std::move(key))
+        , value_(std::move(value))
+        , weight_(0)
+        , prev_(NodePool<UnifiedArcNode>::kNull)
+        , next_(NodePool<UnifiedArcNode>::kNull)
+        , timer_(TimerWheel<uint32_t>::kNone)
+        , list_(ArcList::T1)
+    {}
+
+    template<typename K, typename V, typename I> friend class UnifiedArcCache;
+};
+
+// 单索引的 ARC：T1/T2/B1/B2 四个链表的结点都放在同一个节点池中，由同一张哈希表索引，结点上记录所在的链表。
+// 每次 get / put 只在一把锁内做一次哈希探测（put 用 Index::tryEmplace 一次完成查找或插入），
+// 幽灵命中、分区目标的调整与淘汰都在同一次加锁中完成，可以直接被多个线程共享。
+// 与 ArcCache 的区别：没有 LRU / LFU 两个独立部分与转移阈值，按原始 ARC 的规则，第二次访问即进入 T2；
+// 设置 weigher 时 capacity 为权重上限，幽灵按被淘汰时的权重计入 B1 / B2
+template<typename Key, typename Value, typename Index = StdIndex>
+class UnifiedArcCache : public CachePolicy<Key, Value>
+{
+public:
+    using NodeType = UnifiedArcNode<Key, Value>;
+    using NodePoolType = NodePool<NodeType>;
+    using NodeIndex = typename NodePoolType::Index;
+    using NodeMap = typename Index::template Map<Key, NodeIndex>;
+    using WeigherType = Weigher<Key, Value>;
+
+    explicit UnifiedArcCache(int capacity = 10) : UnifiedArcCache(capacity > 0 ? capacity : 0, nullptr) {}
+
+    UnifiedArcCache(size_t maxWeight, WeigherType weigher)
+        : capacity_(maxWeight)
+        , target_(0)
+        , weigher_(std::move(weigher))
+    {
+        initLists();
+    }
+
+    void put(Key key, Value value) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer.locked();
+        expireLocked();
+        putLocked(std::move(key), std::move(value), 0);
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer.locked();
+        expireLocked();
+        putLocked(std::move(key), std::move(value), expiryDeadline(ttl));
+    }
+
+    bool get(Key key, Value& value) override
+    {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    Value get(Key key) override
+    {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 命中时在锁内以 const Value& 调用 fn，不复制值；fn 应尽快返回，且不能再访问本缓存。
+    // 幽灵不算命中：get 拿不到值，分区目标的调整留给随后写回的 put
+    template<typename K, typename Fn>
+    bool visit(const K& key, Fn&& fn)
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Get);
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer.locked();
+        NodeIndex node = getLocked(key);
+        if (node == NodePoolType::kNull) {
+            this->stats_.add(CacheEvent::Miss);
+            return false;
+        }
+        fn(pool_[node].value_);
+        this->stats_.add(CacheEvent::Hit);
+        return true;
+    }
+
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* found) override
+    {
+        return getMany(keys, nullptr, count, values, found);
+    }
+
+    void putMany(const Key* keys, const Value* values, size_t count) override
+    {
+        putMany(keys, nullptr, count, values);
+    }
+
+    // 只处理 positions 指定的 count 个下标（为空时为 0..count-1），整批只加一次锁
+    size_t getMany(const Key* keys, const uint32_t* positions, size_t count, Value* values, bool* found)
+    {
+        size_t hits = 0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < count; ++i) {
+            size_t pos = positions ? positions[i] : i;
+            NodeIndex node = getLocked(keys[pos]);
+            found[pos] = node != NodePoolType::kNull;
+            if (found[pos]) {
+                values[pos] = pool_[node].value_;
+                ++hits;
+            }
+        }
+        this->stats_.add(CacheEvent::Hit, hits);
+        this->stats_.add(CacheEvent::Miss, count - hits);
+        return hits;
+    }
+
+    void putMany(const Key* keys, const uint32_t* positions, size_t count, const Value* values)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        expireLocked();
+        for (size_t i = 0; i < count; ++i) {
+            size_t pos = positions ? positions[i] : i;
+            putLocked(keys[pos], values[pos], 0);
+        }
+    }
+
+    size_t purgeExpired() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return expireLocked();
+    }
+
+    // 常驻条目数（T1 + T2），不含幽灵
+    size_t size() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return counts_[T1] + counts_[T2];
+    }
+
+    size_t weightedSize() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return weights_[T1] + weights_[T2];
+    }
+
+    // 幽灵数（B1 + B2），幽灵只保存 key 与权重
+    size_t ghostSize()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return counts_[B1] + counts_[B2];
+    }
+
+    // T1 的目标权重（自适应的分区点 p），范围 [0, capacity]
+    size_t target()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return target_;
+    }
+
+    size_t capacity()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    // 调整容量（权重上限），缩小时立即把常驻条目降级为幽灵、并丢弃超出的幽灵
+    void setCapacity(size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        target_ = std::min(target_, capacity_);
+        shrinkLocked();
+    }
+
+    // 快照：容量与分区目标，然后依次是 T1、T2、B1、B2 四个链表，每个链表按最久未访问到最近访问的顺序。
+    // 常驻条目写出 (key, value, 剩余存活时间)，已过期的跳过；幽灵写出 (key, 权重)
+    void saveTo(SnapshotWriter& out)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out.write(static_cast<uint32_t>(SnapshotKind::ArcUnified));
+        out.write(static_cast<uint64_t>(capacity_));
+        out.write(static_cast<uint64_t>(target_));
+        uint64_t now = expiryNow();
+        for (size_t list = T1; list <= B2; ++list) {
+            size_t countAt = out.reserve(sizeof(uint64_t));
+            uint64_t count = 0;
+            for (NodeIndex node = pool_[heads_[list]].next_; node != heads_[list]; node = pool_[node].next_) {
+                const NodeType& n = pool_[node];
+                if (list == B1 || list == B2) {
+                    out.write(n.key_);
+                    out.write(static_cast<uint64_t>(n.weight_));
+                    ++count;
+                    continue;
+                }
+                uint64_t remaining;
+                if (!snapshotRemaining(n.timer_ == TimerWheel<NodeIndex>::kNone ? 0 : wheel_.deadline(n.timer_),
+                                       now, remaining)) {
+                    continue;
+                }
+                out.write(n.key_);
+                out.write(n.value_);
+                out.write(remaining);
+                ++count;
+            }
+            out.patch(countAt, &count, sizeof(count));
+        }
+    }
+
+    // 用快照替换当前内容。容量与保存时不同时按比例换算分区目标，容量变小时按 ARC 的规则降级、丢弃多出的条目；
+    // 数据不完整或类型不符时清空缓存并返回 false
+    bool loadFrom(SnapshotReader& in)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clearLocked();
+        uint32_t kind;
+        uint64_t savedCapacity, savedTarget;
+        if (!in.read(kind) || kind != static_cast<uint32_t>(SnapshotKind::ArcUnified) ||
+            !in.read(savedCapacity) || !in.read(savedTarget) || savedTarget > savedCapacity) {
+            return false;
+        }
+        target_ = savedCapacity == capacity_ || savedCapacity == 0
+                      ? std::min<size_t>(static_cast<size_t>(savedTarget), capacity_)
+                      : static_cast<size_t>(static_cast<double>(savedTarget) / savedCapacity * capacity_);
+        for (size_t list = T1; list <= B2; ++list) {
+            uint64_t count;
+            if (!in.read(count)) {
+                clearLocked();
+                return false;
+            }
+            for (uint64_t i = 0; i < count; ++i) {
+                Key key;
+                Value value{};
+                uint64_t weight = 0, remaining = 0;
+                bool ghost = list == B1 || list == B2;
+                if (!in.read(key) || (ghost ? !in.read(weight) : (!in.read(value) || !in.read(remaining)))) {
+                    clearLocked();
+                    return false;
+                }
+                if (!ghost) {
+                    weight = weighEntry(weigher_, key, value);
+                }
+                if (weight > capacity_) {
+                    continue;
+                }
+                auto result = Index::tryEmplace(nodeMap_, key, NodePoolType::kNull);
+                if (!result.second) {
+                    continue;   // 损坏的快照中重复的 key 只保留第一个
+                }
+                NodeIndex node = pool_.allocate(std::move(key), std::move(value));
+                pool_[node].weight_ = static_cast<size_t>(weight);
+                result.first->second = node;
+                linkLast(node, static_cast<ArcList>(list));
+                setDeadline(node, ghost ? 0 : snapshotDeadline(remaining));
+            }
+        }
+        shrinkLocked();
+        return true;
+    }
+
+    bool saveSnapshot(const std::string& path)
+    {
+        return saveSections(path, 1, [this](size_t, SnapshotWriter& out) { saveTo(out); });
+    }
+
+    bool loadSnapshot(const std::string& path)
+    {
+        return loadSections(path, 1, [this](size_t, SnapshotReader& in) { return loadFrom(in); });
+    }
+
+private:
+    static constexpr size_t T1 = static_cast<size_t>(ArcList::T1);
+    static constexpr size_t T2 = static_cast<size_t>(ArcList::T2);
+    static constexpr size_t B1 = static_cast<size_t>(ArcList::B1);
+    static constexpr size_t B2 = static_cast<size_t>(ArcList::B2);
+
+    // 每个链表一个哨兵结点构成环形链表：next_ 为最久未访问，prev_ 为最近访问
+    void initLists()
+    {
+        for (NodeIndex& head : heads_) {
+            head = pool_.allocate(Key(), Value());
+            pool_[head].prev_ = head;
+            pool_[head].next_ = head;
+        }
+        std::fill(weights_, weights_ + 4, 0);
+        std::fill(counts_, counts_ + 4, 0);
+    }
+
+    void clearLocked()
+    {
+        nodeMap_.clear();
+        wheel_.clear();
+        pool_.clear();
+        target_ = 0;
+        initLists();
+    }
+
+    // 一次探测：命中常驻条目时移到 T2 的最近端并返回结点；幽灵、不存在或已过期时返回 kNull
+    template<typename K>
+    NodeIndex getLocked(const K& key)
+    {
+        auto it = Index::find(nodeMap_, key);
+        if (it == nodeMap_.end()) {
+            return NodePoolType::kNull;
+        }
+        NodeIndex node = it->second;
+        NodeType& n = pool_[node];
+        if (n.list_ == ArcList::B1 || n.list_ == ArcList::B2) {
+            return NodePoolType::kNull;
+        }
+        if (wheel_.expired(n.timer_)) {
+            removeEntry(node);
+            this->stats_.add(CacheEvent::Expiration);
+            return NodePoolType::kNull;
+        }
+        unlink(node);
+        linkLast(node, ArcList::T2);
+        return node;
+    }
+
+    // deadline 为 0 表示不过期。索引只探测一次：新 key 先以 kNull 占位，淘汰完成后再填入结点。
+    // 淘汰只会删除其他 key，两种索引的删除都不会使占位的迭代器失效
+    template<typename K, typename V>
+    void putLocked(K&& key, V&& value, uint64_t deadline)
+    {
+        this->stats_.add(CacheEvent::Put);
+        size_t weight = weighEntry(weigher_, key, value);
+        auto result = Index::tryEmplace(nodeMap_, key, NodePoolType::kNull);
+        auto it = result.first;
+        if (result.second) {
+            if (weight > capacity_) {
+                nodeMap_.erase(it);
+                return;
+            }
+            makeRoomForNew(weight);
+            NodeIndex node = pool_.allocate(std::forward<K>(key), std::forward<V>(value));
+            pool_[node].weight_ = weight;
+            it->second = node;
+            linkLast(node, ArcList::T1);
+            setDeadline(node, deadline);
+            return;
+        }
+
+        NodeIndex node = it->second;
+        NodeType& n = pool_[node];
+        if (weight > capacity_) {
+            removeEntry(node);
+            return;
+        }
+        if (n.list_ == ArcList::B1 || n.list_ == ArcList::B2) {
+            adaptTarget(n.list_, n.weight_);
+        }
+        bool fromB2 = n.list_ == ArcList::B2;
+        unlink(node);
+        n.value_ = std::forward<V>(value);
+        n.weight_ = weight;
+        linkLast(node, ArcList::T2);
+        setDeadline(node, deadline);
+        // 更新后的条目已在 T2 中，腾出空间时不能把它自己降级
+        while (weights_[T1] + weights_[T2] > capacity_ && replace(fromB2, node)) {
+        }
+        trimGhosts();
+    }
+
+    // 幽灵命中：B1 命中说明 T1 太小，目标增大；B2 命中则减小。步长按另一个幽灵表与本表的权重比放大
+    void adaptTarget(ArcList list, size_t weight)
+    {
+        this->stats_.add(CacheEvent::GhostHit);
+        size_t step = std::max<size_t>(weight, 1);
+        size_t previous = target_;
+        if (list == ArcList::B1) {
+            step *= std::max<size_t>(1, weights_[B2] / std::max<size_t>(weights_[B1], 1));
+            target_ = std::min(capacity_, target_ + step);
+        } else {
+            step *= std::max<size_t>(1, weights_[B1] / std::max<size_t>(weights_[B2], 1));
+            target_ = target_ > step ? target_ - step : 0;
+        }
+        if (target_ != previous) {
+            this->stats_.add(CacheEvent::CapacityShift);
+        }
+    }
+
+    // 新 key 进入 T1 之前：L1 = T1 + B1 不超过 capacity，四个链表合计不超过 2 * capacity，常驻部分不超过 capacity
+    void makeRoomForNew(size_t weight)
+    {
+        while (weights_[T1] + weights_[B1] + weight > capacity_ && counts_[B1] > 0) {
+            dropOldest(ArcList::B1);
+        }
+        while (weights_[T1] + weight > capacity_ && counts_[T1] > 0) {
+            // B1 已空而 T1 仍占满：直接淘汰 T1 的最旧条目，不留幽灵
+            removeEntry(pool_[heads_[T1]].next_);
+            this->stats_.add(CacheEvent::Eviction);
+        }
+        while (totalWeight() + weight > 2 * capacity_ && counts_[B2] > 0) {
+            dropOldest(ArcList::B2);
+        }
+        while (weights_[T1] + weights_[T2] + weight > capacity_ && replace(false, NodePoolType::kNull)) {
+        }
+    }
+
+    // ARC 的 REPLACE：T1 超过目标时把它的最旧条目降级到 B1，否则把 T2 的最旧条目降级到 B2。
+    // 选中的是 keep 时改从另一个链表淘汰；没有可淘汰的条目时返回 false
+    bool replace(bool fromB2, NodeIndex keep)
+    {
+        bool useT1 = counts_[T1] > 0 && (weights_[T1] > target_ || (fromB2 && weights_[T1] == target_));
+        if (!useT1 && counts_[T2] == 0) {
+            useT1 = true;
+        }
+        NodeIndex victim = pool_[heads_[useT1 ? T1 : T2]].next_;
+        if (victim == keep || victim == heads_[useT1 ? T1 : T2]) {
+            useT1 = !useT1;
+            victim = pool_[heads_[useT1 ? T1 : T2]].next_;
+            if (victim == keep || victim == heads_[useT1 ? T1 : T2]) {
+                return false;
+            }
+        }
+        NodeType& n = pool_[victim];
+        unlink(victim);
+        releaseValue(n.value_);
+        wheel_.cancel(n.timer_);
+        n.timer_ = TimerWheel<NodeIndex>::kNone;
+        linkLast(victim, useT1 ? ArcList::B1 : ArcList::B2);
+        this->stats_.add(CacheEvent::Eviction);
+        return true;
+    }
+
+    // 幽灵命中后条目的权重可能变大，四个链表合计超过 2 * capacity 时丢弃最旧的幽灵
+    void trimGhosts()
+    {
+        while (totalWeight() > 2 * capacity_ && counts_[B1] + counts_[B2] > 0) {
+            bool useB1 = counts_[B1] > 0 && (counts_[B2] == 0 || weights_[T1] + weights_[B1] > capacity_);
+            dropOldest(useB1 ? ArcList::B1 : ArcList::B2);
+        }
+    }
+
+    // 容量变小或加载快照之后恢复各项上限
+    void shrinkLocked()
+    {
+        while (weights_[T1] + weights_[T2] > capacity_ && replace(false, NodePoolType::kNull)) {
+        }
+        while (weights_[T1] + weights_[B1] > capacity_ && counts_[B1] > 0) {
+            dropOldest(ArcList::B1);
+        }
+        trimGhosts();
+    }
+
+    void dropOldest(ArcList list)
+    {
+        removeEntry(pool_[heads_[static_cast<size_t>(list)]].next_);
+    }
+
+    size_t totalWeight() const { return weights_[T1] + weights_[T2] + weights_[B1] + weights_[B2]; }
+
+    void setDeadline(NodeIndex node, uint64_t deadline)
+    {
+        uint32_t& timer = pool_[node].timer_;
+        if (deadline == 0) {
+            wheel_.cancel(timer);
+            timer = TimerWheel<NodeIndex>::kNone;
+        } else {
+            timer = wheel_.reschedule(timer, node, deadline);
+        }
+    }
+
+    // 推进时间轮，回收到期的常驻条目，不留幽灵
+    size_t expireLocked()
+    {
+        if (wheel_.empty()) {
+            return 0;
+        }
+        size_t expired = wheel_.advance(expiryNow(), [this](NodeIndex node) {
+            pool_[node].timer_ = TimerWheel<NodeIndex>::kNone;
+            removeEntry(node);
+        });
+        this->stats_.add(CacheEvent::Expiration, expired);
+        return expired;
+    }
+
+    // 从所在链表、索引和时间轮中移除结点，槽位回到节点池的空闲链表中
+    void removeEntry(NodeIndex node)
+    {
+        unlink(node);
+        wheel_.cancel(pool_[node].timer_);
+        nodeMap_.erase(pool_[node].key_);
+        pool_.release(node);
+    }
+
+    void unlink(NodeIndex node)
+    {
+        NodeType& n = pool_[node];
+        size_t list = static_cast<size_t>(n.list_);
+        weights_[list] -= n.weight_;
+        --counts_[list];
+        pool_[n.prev_].next_ = n.next_;
+        pool_[n.next_].prev_ = n.prev_;
+    }
+
+    // 插入到 list 的最近端
+    void linkLast(NodeIndex node, ArcList list)
+    {
+        size_t l = static_cast<size_t>(list);
+        NodeType& n = pool_[node];
+        NodeType& head = pool_[heads_[l]];
+        n.list_ = list;
+        n.next_ = heads_[l];
+        n.prev_ = head.prev_;
+        pool_[head.prev_].next_ = node;
+        head.prev_ = node;
+        weights_[l] += n.weight_;
+        ++counts_[l];
+    }
+
+private:
+    size_t       capacity_;     // 常驻条目的权重上限 c，幽灵另外最多再占 c
+    size_t       target_;       // T1 的目标权重 p
+    WeigherType  weigher_;
+    std::mutex   mutex_;
+    NodeMap      nodeMap_;      // 四个链表共用的索引
+    NodePoolType pool_;
+    NodeIndex    heads_[4];     // 按 ArcList 取下标的哨兵结点
+    size_t       weights_[4];
+    size_t       counts_[4];
+    TimerWheel<NodeIndex> wheel_;   // 设置了过期时间的常驻条目
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// 分片缓存的批量操作辅助：把一批 key 按所属分片分组，
+// 同一分片的 key 以下标数组的形式一次性交给 apply(slice, positions, n)，
+// 分片内部据此只加一次锁。分组用的是栈上的定长缓冲区，整个过程不分配内存；
+// 超过 kShardBatch 个 key 时分多轮处理，每轮每个分片至多加锁一次。
+constexpr size_t kShardBatch = 256;
+
+template<typename Key, typename ShardFn, typename ApplyFn>
+void forEachShardGroup(const Key* keys, size_t count, ShardFn shardOf, ApplyFn apply)
+{
+    uint32_t positions[kShardBatch];
+    uint32_t shards[kShardBatch];
+
+    for (size_t base = 0; base < count; base += kShardBatch) {
+        size_t n = std::min(kShardBatch, count - base);
+        for (size_t i = 0; i < n; ++i) {
+            positions[i] = static_cast<uint32_t>(i);
+            shards[i] = static_cast<uint32_t>(shardOf(keys[base + i]));
+        }
+        std::sort(positions, positions + n, [&shards](uint32_t a, uint32_t b) {
+            return shards[a] < shards[b];
+        });
+
+        // 排序后把相对下标换成在整批中的绝对下标，再按分片切成若干段
+        size_t start = 0;
+        while (start < n) {
+            uint32_t shard = shards[positions[start]];
+            size_t end = start;
+            while (end < n && shards[positions[end]] == shard) {
+                positions[end] += static_cast<uint32_t>(base);
+                ++end;
+            }
+            apply(shard, positions + start, end - start);
+            start = end;
+        }
+    }
+}
@@ -0,0 +1,301 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "MappedFile.h"
+#include "TimerWheel.h"
+
+// 快照序列化约定。Serializer<T> 负责把一个 T 追加到 SnapshotWriter / 从 SnapshotReader 中读出，
+// 默认实现按原始字节拷贝，只适用于可平凡复制的类型；std::string 已有特化，
+// 其他类型（含指针或自有内存的）由使用方自行特化：
+//   template<> struct Serializer<MyType> {
+//       static void write(SnapshotWriter& out, const MyType& v);
+//       static bool read(SnapshotReader& in, MyType& v);   // 数据不完整时返回 false
+//   };
+class SnapshotWriter;
+class SnapshotReader;
+
+template<typename T, typename Enable = void>
+struct Serializer
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Serializer<T> must be specialized for non trivially copyable types");
+
+    static void write(SnapshotWriter& out, const T& value);
+    static bool read(SnapshotReader& in, T& value);
+};
+
+// 追加写入的内存缓冲区，写完后整体落盘
+class SnapshotWriter
+{
+public:
+    void writeBytes(const void* data, size_t size)
+    {
+        buffer_.append(static_cast<const char*>(data), size);
+    }
+
+    template<typename T>
+    void write(const T& value)
+    {
+        Serializer<T>::write(*this, value);
+    }
+
+    // 先占位、后回填：条目数要在遍历完之后才知道
+    size_t reserve(size_t size)
+    {
+        size_t offset = buffer_.size();
+        buffer_.append(size, '\0');
+        return offset;
+    }
+
+    void patch(size_t offset, const void* data, size_t size)
+    {
+        std::memcpy(&buffer_[offset], data, size);
+    }
+
+    const std::string& buffer() const { return buffer_; }
+    size_t size() const { return buffer_.size(); }
+
+private:
+    std::string buffer_;
+};
+
+// 在 [begin, end) 上顺序读取，越界时返回 false 而不是读出垃圾数据
+class SnapshotReader
+{
+public:
+    SnapshotReader(const char* begin, const char* end) : cur_(begin), end_(end) {}
+
+    bool readBytes(void* data, size_t size)
+    {
+        if (static_cast<size_t>(end_ - cur_) < size) {
+            return false;
+        }
+        std::memcpy(data, cur_, size);
+        cur_ += size;
+        return true;
+    }
+
+    // 不拷贝，直接返回映射区域中的 size 个字节
+    const char* take(size_t size)
+    {
+        if (static_cast<size_t>(end_ - cur_) < size) {
+            return nullptr;
+        }
+        const char* p = cur_;
+        cur_ += size;
+        return p;
+    }
+
+    template<typename T>
+    bool read(T& value)
+    {
+        return Serializer<T>::read(*this, value);
+    }
+
+    bool atEnd() const { return cur_ == end_; }
+
+private:
+    const char* cur_;
+    const char* end_;
+};
+
+template<typename T, typename Enable>
+void Serializer<T, Enable>::write(SnapshotWriter& out, const T& value)
+{
+    out.writeBytes(&value, sizeof(T));
+}
+
+template<typename T, typename Enable>
+bool Serializer<T, Enable>::read(SnapshotReader& in, T& value)
+{
+    return in.readBytes(&value, sizeof(T));
+}
+
+template<>
+struct Serializer<std::string>
+{
+    static void write(SnapshotWriter& out, const std::string& value)
+    {
+        uint32_t length = static_cast<uint32_t>(value.size());
+        out.writeBytes(&length, sizeof(length));
+        out.writeBytes(value.data(), value.size());
+    }
+
+    static bool read(SnapshotReader& in, std::string& value)
+    {
+        uint32_t length;
+        if (!in.readBytes(&length, sizeof(length))) {
+            return false;
+        }
+        const char* data = in.take(length);
+        if (!data) {
+            return false;
+        }
+        value.assign(data, length);
+        return true;
+    }
+};
+
+// 快照中标记缓存类型，避免把 LRU 的快照加载进 LFU。
+// Arc 为幽灵保存完整 key 的旧格式（仍可加载），ArcGhostFingerprint 为幽灵只保存 64 位指纹的格式，
+// ArcUnified 为单索引 ARC（UnifiedArcCache）的四个链表
+enum class SnapshotKind : uint32_t { Lru = 1, Lfu = 2, Arc = 3, ArcGhostFingerprint = 4, ArcUnified = 5 };
+
+// 条目剩余的存活时间（毫秒），0 表示不过期；已经过期的条目返回 false，不写入快照。
+// 快照里不保存绝对刻度：刻度以进程启动为原点，换一个进程就没有意义了
+inline bool snapshotRemaining(uint64_t deadline, uint64_t now, uint64_t& remaining)
+{
+    if (deadline == 0) {
+        remaining = 0;
+        return true;
+    }
+    if (deadline <= now) {
+        return false;
+    }
+    remaining = deadline - now;
+    return true;
+}
+
+// 恢复时把剩余时间换算回当前进程的刻度
+inline uint64_t snapshotDeadline(uint64_t remaining)
+{
+    return remaining == 0 ? 0 : expiryNow() + remaining;
+}
+
+// 快照文件布局：
+//   magic 'CSNP' | version | section 数 n | layout | n 个 {offset, size} | 各 section 的数据
+// 每个 section 独立编码，分片缓存一个分片一个 section，保存和恢复都可以并行。
+// layout 描述 key 到 section 的映射（分片缓存为路由的 snapshotLayout()，非分片缓存为 0），
+// 加载时必须与当前缓存一致，否则条目会落进错误的分片、永远无法命中。
+// 版本 1 没有 layout 字段，只能加载进 layout 为 0 的非分片缓存。
+namespace snapshot_detail
+{
+constexpr uint32_t kMagic = 0x504E5343;    // "CSNP"
+constexpr uint32_t kVersion = 2;
+
+struct SectionEntry
+{
+    uint64_t offset;
+    uint64_t size;
+};
+
+// 用 min(硬件线程数, count) 个线程从共享下标里领取任务；count 为 1 时就在当前线程执行
+template<typename Fn>
+void parallelFor(size_t count, Fn fn)
+{
+    size_t workers = std::min<size_t>(count, std::max<size_t>(1, std::thread::hardware_concurrency()));
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next{0};
+    auto run = [&]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            fn(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < workers; ++t) {
+        threads.emplace_back(run);
+    }
+    run();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+} // namespace snapshot_detail
+
+// 并行编码 count 个 section（fn(i, SnapshotWriter&)），写入临时文件后 rename，
+// 中途失败不会破坏已有的快照
+template<typename Fn>
+bool saveSections(const std::string& path, size_t count, Fn fn, uint64_t layout = 0)
+{
+    using namespace snapshot_detail;
+    std::vector<SnapshotWriter> sections(count);
+    parallelFor(count, [&](size_t i) { fn(i, sections[i]); });
+
+    std::vector<SectionEntry> table(count);
+    uint64_t offset = sizeof(uint32_t) * 3 + sizeof(uint64_t) + sizeof(SectionEntry) * count;
+    for (size_t i = 0; i < count; ++i) {
+        table[i].offset = offset;
+        table[i].size = sections[i].size();
+        offset += sections[i].size();
+    }
+
+    std::string tmp = path + ".tmp";
+    std::FILE* file = std::fopen(tmp.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    uint32_t header[3] = { kMagic, kVersion, static_cast<uint32_t>(count) };
+    bool ok = std::fwrite(header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(&layout, sizeof(layout), 1, file) == 1;
+    ok = ok && (count == 0 || std::fwrite(table.data(), sizeof(SectionEntry), count, file) == count);
+    for (size_t i = 0; ok && i < count; ++i) {
+        const std::string& data = sections[i].buffer();
+        ok = data.empty() || std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// 映射快照文件并并行解码各 section（fn(i, SnapshotReader&) -> bool）。
+// 文件头损坏、section 数与 count 不一致或 layout 不同时不调用 fn，直接返回 false
+template<typename Fn>
+bool loadSections(const std::string& path, size_t count, Fn fn, uint64_t layout = 0)
+{
+    using namespace snapshot_detail;
+    // 整个文件马上就要读完，提前预读
+    MappedFile file(path, MADV_WILLNEED);
+    if (!file.valid()) {
+        return false;
+    }
+    SnapshotReader header(file.data(), file.data() + file.size());
+    uint32_t magic, version, sections;
+    if (!header.read(magic) || !header.read(version) || !header.read(sections) ||
+        magic != kMagic || sections != count) {
+        return false;
+    }
+    uint64_t savedLayout = 0;
+    if (version == kVersion) {
+        if (!header.read(savedLayout)) {
+            return false;
+        }
+    } else if (version != 1) {
+        return false;
+    }
+    if (savedLayout != layout) {
+        return false;
+    }
+    std::vector<SectionEntry> table(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (!header.read(table[i]) || table[i].offset > file.size() ||
+            table[i].size > file.size() - table[i].offset) {
+            return false;
+        }
+    }
+
+    std::atomic<bool> ok{true};
+    parallelFor(count, [&](size_t i) {
+        const char* begin = file.data() + table[i].offset;
+        SnapshotReader reader(begin, begin + table[i].size);
+        if (!fn(i, reader)) {
+            ok.store(false, std::memory_order_relaxed);
+        }
+    });
+    return ok.load();
+}
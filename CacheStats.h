@@ -0,0 +1,257 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "LatencyHistogram.h"
+
+// 编译时定义 CACHE_DISABLE_STATS 可以关闭所有统计：记录调用都变成空操作，stats() 返回全 0
+#ifdef CACHE_DISABLE_STATS
+constexpr bool kCacheStatsEnabled = false;
+#else
+constexpr bool kCacheStatsEnabled = true;
+#endif
+
+enum class CacheEvent : uint32_t
+{
+    Hit,
+    Miss,
+    Put,
+    Eviction,       // 因容量淘汰（不含过期与显式删除）
+    Expiration,     // 因过期回收
+    GhostHit,       // 命中幽灵 / 测试页（ARC 的 B1/B2，CLOCK-Pro 的 test 页）
+    CapacityShift,  // 自适应调整了分区目标（ARC 两部分之间转移容量，CLOCK-Pro 调整冷页目标）
+    AgingRun,       // 频次整体衰减（LFU 的平均频次超限，TinyLFU 的 sketch 减半）
+    Count
+};
+
+// 某一时刻统计的拷贝，可以跨分片累加。延迟单位为纳秒，只包含被采样到的操作
+struct CacheStatsSnapshot
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t puts = 0;
+    uint64_t evictions = 0;
+    uint64_t expirations = 0;
+    uint64_t ghostHits = 0;
+    uint64_t capacityShifts = 0;
+    uint64_t agingRuns = 0;
+
+    LatencyHistogram getLatency;
+    LatencyHistogram putLatency;
+    LatencyHistogram lockWait;      // 从开始等锁到拿到锁
+
+    double hitRate() const
+    {
+        uint64_t lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+    }
+
+    CacheStatsSnapshot& operator+=(const CacheStatsSnapshot& other)
+    {
+        hits += other.hits;
+        misses += other.misses;
+        puts += other.puts;
+        evictions += other.evictions;
+        expirations += other.expirations;
+        ghostHits += other.ghostHits;
+        capacityShifts += other.capacityShifts;
+        agingRuns += other.agingRuns;
+        getLatency.merge(other.getLatency);
+        putLatency.merge(other.putLatency);
+        lockWait.merge(other.lockWait);
+        return *this;
+    }
+};
+
+// 每个缓存实例（分片缓存中即每个分片）一份。计数器各占一个缓存行，读写都是 relaxed：
+// add 给已持有独占锁的路径用，只有普通的读和写；addConcurrent 给共享锁下并发的读路径用，
+// 按线程分散到几个条带上做原子加，读线程之间不争抢同一个缓存行。
+// 延迟直方图默认关闭，setSampling(n) 之后每个线程每 n 次操作采样一次（n 取 2 的幂），
+// 采样到的操作才读时钟，记录时加一把只有采样路径才会碰到的锁。
+class CacheStats
+{
+public:
+    enum class Op { Get, Put };
+
+    CacheStats() = default;
+    CacheStats(const CacheStats&) = delete;
+    CacheStats& operator=(const CacheStats&) = delete;
+
+    void add(CacheEvent event, uint64_t n = 1)
+    {
+        if (kCacheStatsEnabled) {
+            std::atomic<uint64_t>& counter = counters_[static_cast<size_t>(event)].value;
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    }
+
+    void addConcurrent(CacheEvent event, uint64_t n = 1)
+    {
+        if (kCacheStatsEnabled) {
+            stripes_[stripeIndex()].counts[static_cast<size_t>(event)].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    // every 为 0 时关闭采样；其余值向上取整到 2 的幂
+    void setSampling(uint32_t every)
+    {
+        uint32_t mask = 0;
+        if (every > 0) {
+            uint32_t pow2 = 1;
+            while (pow2 < every && pow2 < (1u << 31)) {
+                pow2 <<= 1;
+            }
+            mask = pow2 - 1;
+        }
+        std::lock_guard<std::mutex> lock(sampleMutex_);
+        if (every > 0 && !histograms_) {
+            histograms_.reset(new Histograms());
+        }
+        sampleMask_.store(every > 0 ? mask : kSamplingOff, std::memory_order_relaxed);
+    }
+
+    // get 与 put 各自计数，交替调用时两种操作都能被采样到
+    bool shouldSample(Op op) const
+    {
+        if (!kCacheStatsEnabled) {
+            return false;
+        }
+        uint32_t mask = sampleMask_.load(std::memory_order_relaxed);
+        if (mask == kSamplingOff) {
+            return false;
+        }
+        static thread_local uint32_t ticks[2] = {0, 0};
+        return (++ticks[static_cast<size_t>(op)] & mask) == 0;
+    }
+
+    void recordSample(Op op, uint64_t lockWaitNs, uint64_t totalNs)
+    {
+        std::lock_guard<std::mutex> lock(sampleMutex_);
+        if (!histograms_) {
+            return;
+        }
+        histograms_->lockWait.record(lockWaitNs);
+        (op == Op::Get ? histograms_->get : histograms_->put).record(totalNs);
+    }
+
+    CacheStatsSnapshot snapshot() const
+    {
+        CacheStatsSnapshot s;
+        if (!kCacheStatsEnabled) {
+            return s;
+        }
+        s.hits = load(CacheEvent::Hit);
+        s.misses = load(CacheEvent::Miss);
+        s.puts = load(CacheEvent::Put);
+        s.evictions = load(CacheEvent::Eviction);
+        s.expirations = load(CacheEvent::Expiration);
+        s.ghostHits = load(CacheEvent::GhostHit);
+        s.capacityShifts = load(CacheEvent::CapacityShift);
+        s.agingRuns = load(CacheEvent::AgingRun);
+        std::lock_guard<std::mutex> lock(sampleMutex_);
+        if (histograms_) {
+            s.getLatency = histograms_->get;
+            s.putLatency = histograms_->put;
+            s.lockWait = histograms_->lockWait;
+        }
+        return s;
+    }
+
+private:
+    static constexpr uint32_t kSamplingOff = UINT32_MAX;
+
+    static constexpr size_t kStripes = 8;
+
+    struct alignas(64) PaddedCounter
+    {
+        std::atomic<uint64_t> value{0};
+    };
+
+    // 一个条带正好一个缓存行，放下全部事件的计数
+    struct alignas(64) Stripe
+    {
+        std::atomic<uint64_t> counts[static_cast<size_t>(CacheEvent::Count)] = {};
+    };
+
+    static size_t stripeIndex()
+    {
+        static thread_local size_t index =
+            (std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ull) >> 61;
+        return index;
+    }
+
+    struct Histograms
+    {
+        LatencyHistogram get;
+        LatencyHistogram put;
+        LatencyHistogram lockWait;
+    };
+
+    uint64_t load(CacheEvent event) const
+    {
+        size_t i = static_cast<size_t>(event);
+        uint64_t total = counters_[i].value.load(std::memory_order_relaxed);
+        for (const Stripe& stripe : stripes_) {
+            total += stripe.counts[i].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    PaddedCounter                counters_[static_cast<size_t>(CacheEvent::Count)];
+    Stripe                       stripes_[kStripes];
+    std::atomic<uint32_t>        sampleMask_{kSamplingOff};
+    mutable std::mutex           sampleMutex_;
+    std::unique_ptr<Histograms>  histograms_;
+};
+
+// 一次操作的采样计时：构造时开始计时，拿到锁后调用 locked()，析构时记录。
+// 没有被采样的操作只多一次线程局部计数
+class StatsTimer
+{
+public:
+    StatsTimer(CacheStats& stats, CacheStats::Op op)
+        : stats_(stats), op_(op), sampled_(stats.shouldSample(op))
+    {
+        if (sampled_) {
+            start_ = lockedAt_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    void locked()
+    {
+        if (sampled_) {
+            lockedAt_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~StatsTimer()
+    {
+        if (sampled_) {
+            auto end = std::chrono::steady_clock::now();
+            stats_.recordSample(op_, nanos(lockedAt_ - start_), nanos(end - start_));
+        }
+    }
+
+    StatsTimer(const StatsTimer&) = delete;
+    StatsTimer& operator=(const StatsTimer&) = delete;
+
+private:
+    static uint64_t nanos(std::chrono::steady_clock::duration d)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    }
+
+private:
+    CacheStats&                           stats_;
+    CacheStats::Op                        op_;
+    bool                                  sampled_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point lockedAt_;
+};
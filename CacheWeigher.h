@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+// 条目权重：返回一个条目计入容量的大小（例如按字节计的 value 长度）。
+// 为空时每个条目的权重为 1，容量即条目数。权重在淘汰时重新计算而不是存进结点，
+// 因此 weigher 必须是纯函数：同一个 key/value 多次调用结果相同。
+template<typename Key, typename Value>
+using Weigher = std::function<size_t(const Key&, const Value&)>;
+
+template<typename Key, typename Value>
+inline size_t weighEntry(const Weigher<Key, Value>& weigher, const Key& key, const Value& value)
+{
+    return weigher ? weigher(key, value) : 1;
+}
@@ -1,4 +1,21 @@
 #pragma once
+#include <chrono>
+#include <cstddef>
+#include <utility>
+
+#include "CacheStats.h"
+
+// 把值重置为 Value() 并释放它占用的内存。直接赋值 Value() 时 std::string、std::vector 等类型
+// 会留着原来的堆缓冲区，这里先把值移到临时对象里随之销毁
+template<typename Value>
+void releaseValue(Value& value)
+{
+    {
+        Value released = std::move(value);
+    }
+    value = Value();
+}
+
 template <typename Key, typename Value> 
 class CachePolicy 
 {
@@ -10,4 +27,46 @@ public:
     virtual bool get(Key key, Value& value) = 0;
 
     virtual Value get(Key key) = 0;
-};
\ No newline at end of file
+
+    // 带过期时间的写入：ttl 之后条目视为不存在；不带 ttl 的 put 会清除条目已有的过期时间
+    virtual void put(Key key, Value value, std::chrono::milliseconds ttl) = 0;
+
+    // 维护入口：回收所有已经过期的条目，返回回收的个数。过期条目被访问到时也会顺带回收
+    virtual size_t purgeExpired() = 0;
+
+    // 当前缓存的条目数
+    virtual size_t size() = 0;
+
+    // 当前所有条目的权重之和；未设置 weigher 时与 size() 相同
+    virtual size_t weightedSize() = 0;
+
+    // 批量查询：keys/values/found 都是调用方提供的长度为 count 的缓冲区，调用本身不分配内存。
+    // found[i] 标记 keys[i] 是否命中，命中时结果写入 values[i]，返回命中个数。
+    // 默认逐个调用 get，各策略可覆盖为整批只加一次锁。
+    virtual size_t getMany(const Key* keys, size_t count, Value* values, bool* found)
+    {
+        size_t hits = 0;
+        for (size_t i = 0; i < count; ++i) {
+            found[i] = get(keys[i], values[i]);
+            hits += found[i] ? 1 : 0;
+        }
+        return hits;
+    }
+
+    // 批量写入 count 个 keys[i] -> values[i]
+    virtual void putMany(const Key* keys, const Value* values, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            put(keys[i], values[i]);
+        }
+    }
+
+    // 命中、淘汰等计数与采样到的延迟分布（见 CacheStats.h）。包装其他缓存的实现转发给内层缓存
+    virtual CacheStatsSnapshot stats() { return stats_.snapshot(); }
+
+    // 每个线程每 every 次 get/put 采样一次延迟与等锁时间，0 表示关闭（默认）
+    virtual void setStatsSampling(uint32_t every) { stats_.setSampling(every); }
+
+protected:
+    CacheStats stats_;
+};
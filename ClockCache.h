@@ -0,0 +1,861 @@
+#pragma once
+#include "Cachepolicy.h"
+#include "CacheWeigher.h"
+#include "NodePool.h"
+#include "ShardRouter.h"
+#include "TimerWheel.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+// CLOCK 系列缓存：命中时只在共享锁下原子地置位访问位，
+// 不移动任何链表结点；所有链表/指针的调整都放到淘汰路径（独占锁）上完成。
+// 过期的条目在共享锁下只当作未命中，由下一次写入或 purgeExpired 在独占锁下回收。
+
+template<typename Key, typename Value> class ClockCache;
+template<typename Key, typename Value> class ClockProCache;
+
+template<typename Key, typename Value>
+class ClockSlot
+{
+private:
+    Key key_;
+    Value value_;
+    std::atomic<bool> referenced_;
+    bool occupied_;
+    uint32_t timer_;    // 过期定时器，没有过期时间时为 kNone
+
+public:
+    ClockSlot() : key_(), value_(), referenced_(false), occupied_(false), timer_(TimerWheel<uint32_t>::kNone) {}
+
+    friend class ClockCache<Key, Value>;
+};
+
+// 经典 CLOCK：环形数组 + 一根时钟指针。按条目计容量时环的大小就是容量；
+// 按权重计时条目数不固定，环按需增长，淘汰腾出的槽位进入空闲链表复用
+template<typename Key, typename Value>
+class ClockCache : public CachePolicy<Key, Value>
+{
+public:
+    using SlotType = ClockSlot<Key, Value>;
+    using SlotMap = std::unordered_map<Key, uint32_t>;
+    using WeigherType = Weigher<Key, Value>;
+
+    explicit ClockCache(int capacity)
+        : ClockCache(capacity > 0 ? capacity : 0, nullptr)
+    {}
+
+    ClockCache(size_t maxWeight, WeigherType weigher)
+        : capacity_(maxWeight)
+        , weightedSize_(0)
+        , hand_(0)
+        , weigher_(std::move(weigher))
+    {}
+
+    ~ClockCache() override = default;
+
+    void put(Key key, Value value) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        // 容量可能被 setCapacity 调整，在锁内检查
+        if (capacity_ == 0) {
+            return;
+        }
+        expireLocked();
+        putLocked(std::move(key), std::move(value), 0);
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        if (capacity_ == 0) {
+            return;
+        }
+        expireLocked();
+        putLocked(std::move(key), std::move(value), expiryDeadline(ttl));
+    }
+
+    bool get(Key key, Value& value) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Get);
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        bool hit = getLocked(key, value);
+        this->stats_.addConcurrent(hit ? CacheEvent::Hit : CacheEvent::Miss);
+        return hit;
+    }
+
+    Value get(Key key) override
+    {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* found) override
+    {
+        return getMany(keys, nullptr, count, values, found);
+    }
+
+    void putMany(const Key* keys, const Value* values, size_t count) override
+    {
+        putMany(keys, nullptr, count, values);
+    }
+
+    // 只处理 positions 指定的下标（为空时为 0..count-1），整批只加一次锁
+    size_t getMany(const Key* keys, const uint32_t* positions, size_t count, Value* values, bool* found)
+    {
+        size_t hits = 0;
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (size_t i = 0; i < count; ++i) {
+            size_t pos = positions ? positions[i] : i;
+            found[pos] = getLocked(keys[pos], values[pos]);
+            hits += found[pos] ? 1 : 0;
+        }
+        this->stats_.addConcurrent(CacheEvent::Hit, hits);
+        this->stats_.addConcurrent(CacheEvent::Miss, count - hits);
+        return hits;
+    }
+
+    void putMany(const Key* keys, const uint32_t* positions, size_t count, const Value* values)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (capacity_ == 0) {
+            return;
+        }
+        expireLocked();
+        for (size_t i = 0; i < count; ++i) {
+            size_t pos = positions ? positions[i] : i;
+            putLocked(keys[pos], values[pos], 0);
+        }
+    }
+
+    size_t purgeExpired() override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        return expireLocked();
+    }
+
+    size_t size() override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return slotMap_.size();
+    }
+
+    size_t weightedSize() override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return weightedSize_;
+    }
+
+    size_t capacity()
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    // 调整容量（权重上限），缩小时立即转动指针淘汰到新容量以内。供分片缓存在分片之间转移容量（见 ShardRebalancer.h）
+    void setCapacity(size_t capacity)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        capacity_ = capacity;
+        while (weightedSize_ > capacity_ && !slotMap_.empty()) {
+            release(evictOne());
+            this->stats_.add(CacheEvent::Eviction);
+        }
+    }
+
+    // 分片迁移（见 ShardRouter.h 中的 migrateEntries）：从时钟指针处开始转一圈，
+    // 把 pred(key) 为 true 的条目移出本缓存交给 sink，已过期的条目直接丢弃。返回移出的条目数
+    template<typename Pred, typename Sink>
+    size_t extractIf(Pred pred, Sink sink)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        size_t extracted = 0;
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            uint32_t idx = static_cast<uint32_t>((hand_ + i) % slots_.size());
+            SlotType& slot = slots_[idx];
+            if (!slot.occupied_) {
+                continue;
+            }
+            if (wheel_.expired(slot.timer_)) {
+                release(idx);
+            } else if (pred(slot.key_)) {
+                uint64_t deadline = slot.timer_ == TimerWheel<uint32_t>::kNone ? 0 : wheel_.deadline(slot.timer_);
+                weightedSize_ -= weightOf(slot);
+                wheel_.cancel(slot.timer_);
+                slot.timer_ = TimerWheel<uint32_t>::kNone;
+                slotMap_.erase(slot.key_);
+                slot.occupied_ = false;
+                sink(ShardEntry<Key, Value>{std::move(slot.key_), std::move(slot.value_), deadline, 1});
+                releaseValue(slot.key_);
+                releaseValue(slot.value_);
+                freeSlots_.push_back(idx);
+                ++extracted;
+            }
+        }
+        return extracted;
+    }
+
+    // 接收迁移来的条目，访问位清零写入；本缓存中已有的 key 保留现有的值
+    void adopt(std::vector<ShardEntry<Key, Value>>& entries)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (auto& entry : entries) {
+            if (capacity_ > 0 && slotMap_.find(entry.key) == slotMap_.end()) {
+                putLocked(std::move(entry.key), std::move(entry.value), entry.deadline);
+            }
+        }
+    }
+
+private:
+    size_t weightOf(const SlotType& slot) const { return weighEntry(weigher_, slot.key_, slot.value_); }
+
+    // deadline 为 0 表示不过期；过期时间先于淘汰设好，槽位被淘汰时定时器一并取消
+    template<typename K, typename V>
+    void putLocked(K&& key, V&& value, uint64_t deadline)
+    {
+        this->stats_.add(CacheEvent::Put);
+        auto it = slotMap_.find(key);
+        if (it != slotMap_.end()) {
+            setExpiry(it->second, deadline);
+            SlotType& slot = slots_[it->second];
+            weightedSize_ -= weightOf(slot);
+            slot.value_ = std::forward<V>(value);
+            size_t weight = weightOf(slot);
+            weightedSize_ += weight;
+            if (weight > capacity_) {
+                release(it->second);
+                return;
+            }
+            slot.referenced_.store(true, std::memory_order_relaxed);
+            // 值变大后继续转动指针淘汰；刚更新的槽位已置访问位，至少能撑过一圈
+            while (weightedSize_ > capacity_) {
+                release(evictOne());
+                this->stats_.add(CacheEvent::Eviction);
+            }
+            return;
+        }
+
+        size_t weight = weighEntry(weigher_, key, value);
+        if (weight > capacity_) {
+            return;
+        }
+        while (weightedSize_ + weight > capacity_ && !slotMap_.empty()) {
+            release(evictOne());
+            this->stats_.add(CacheEvent::Eviction);
+        }
+
+        uint32_t idx;
+        if (!freeSlots_.empty()) {
+            idx = freeSlots_.back();
+            freeSlots_.pop_back();
+        } else {
+            idx = static_cast<uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+        // key 在槽位和索引中各存一份：先复制进槽位，再把参数本身移动进索引
+        SlotType& slot = slots_[idx];
+        slot.key_ = key;
+        slot.value_ = std::forward<V>(value);
+        slot.occupied_ = true;
+        slot.referenced_.store(false, std::memory_order_relaxed);
+        slotMap_.emplace(std::forward<K>(key), idx);
+        weightedSize_ += weight;
+        setExpiry(idx, deadline);
+    }
+
+    void setExpiry(uint32_t idx, uint64_t deadline)
+    {
+        uint32_t& timer = slots_[idx].timer_;
+        if (deadline == 0) {
+            wheel_.cancel(timer);
+            timer = TimerWheel<uint32_t>::kNone;
+        } else {
+            timer = wheel_.reschedule(timer, idx, deadline);
+        }
+    }
+
+    size_t expireLocked()
+    {
+        if (wheel_.empty()) {
+            return 0;
+        }
+        size_t expired = wheel_.advance(expiryNow(), [this](uint32_t idx) {
+            slots_[idx].timer_ = TimerWheel<uint32_t>::kNone;
+            release(idx);
+        });
+        this->stats_.add(CacheEvent::Expiration, expired);
+        return expired;
+    }
+
+    void release(uint32_t idx)
+    {
+        SlotType& slot = slots_[idx];
+        weightedSize_ -= weightOf(slot);
+        wheel_.cancel(slot.timer_);
+        slot.timer_ = TimerWheel<uint32_t>::kNone;
+        slotMap_.erase(slot.key_);
+        slot.occupied_ = false;
+        releaseValue(slot.key_);
+        releaseValue(slot.value_);
+        freeSlots_.push_back(idx);
+    }
+
+    bool getLocked(const Key& key, Value& value)
+    {
+        auto it = slotMap_.find(key);
+        if (it == slotMap_.end()) {
+            return false;
+        }
+        SlotType& slot = slots_[it->second];
+        if (wheel_.expired(slot.timer_)) {
+            return false;
+        }
+        slot.referenced_.store(true, std::memory_order_relaxed);
+        value = slot.value_;
+        return true;
+    }
+
+    // 指针扫过的槽位若被访问过则清除访问位并给它第二次机会，否则选为淘汰对象；空闲槽位直接跳过
+    uint32_t evictOne()
+    {
+        while (true) {
+            uint32_t idx = hand_;
+            SlotType& slot = slots_[idx];
+            hand_ = static_cast<uint32_t>((hand_ + 1) % slots_.size());
+            if (!slot.occupied_) {
+                continue;
+            }
+            if (slot.referenced_.load(std::memory_order_relaxed)) {
+                slot.referenced_.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            return idx;
+        }
+    }
+
+private:
+    size_t                       capacity_;      // 权重上限，未设置 weigher 时即条目数上限
+    size_t                       weightedSize_;
+    uint32_t                     hand_;
+    WeigherType                  weigher_;
+    std::deque<SlotType>         slots_;         // deque 扩容时已有槽位地址不变
+    std::vector<uint32_t>        freeSlots_;
+    SlotMap                      slotMap_;
+    TimerWheel<uint32_t>         wheel_;         // 设置了过期时间的槽位
+    std::shared_mutex            mutex_;
+};
+
+template<typename Key, typename Value>
+class ClockProNode
+{
+private:
+    enum class Type : uint8_t { Hot, Cold, Test };
+
+    Key key_;
+    Value value_;
+    std::atomic<bool> referenced_;
+    Type type_;
+    uint32_t prev_;
+    uint32_t next_;
+    uint32_t timer_;    // 驻留结点的过期定时器，测试页与没有过期时间的结点为 kNone
+
+public:
+    ClockProNode(Key key, Value value)
+        : key_(std::move(key))
+        , value_(std::move(value))
+        , referenced_(false)
+        , type_(Type::Cold)
+        , prev_(NodePool<ClockProNode>::kNull)
+        , next_(NodePool<ClockProNode>::kNull)
+        , timer_(TimerWheel<uint32_t>::kNone)
+    {}
+
+    friend class ClockProCache<Key, Value>;
+};
+
+// CLOCK-Pro：冷/热/测试三类结点共用一个环，三根指针分别负责冷页淘汰、
+// 热页降级和测试页（只保留 key 的非驻留结点）回收。测试期内再次被 put 的冷页
+// 直接升为热页，并扩大冷页目标容量，从而抵抗一次性扫描对热数据的冲刷。
+template<typename Key, typename Value>
+class ClockProCache : public CachePolicy<Key, Value>
+{
+public:
+    using NodeType = ClockProNode<Key, Value>;
+    using Type = typename NodeType::Type;
+    using NodePoolType = NodePool<NodeType>;
+    using NodeIndex = typename NodePoolType::Index;
+    using NodeMap = std::unordered_map<Key, NodeIndex>;
+    using WeigherType = Weigher<Key, Value>;
+
+    explicit ClockProCache(int capacity)
+        : ClockProCache(capacity > 0 ? capacity : 0, nullptr)
+    {}
+
+    // 按权重计容量：冷/热页的统计与冷页目标容量都按权重计，测试页只保留 key，仍按个数计
+    ClockProCache(size_t maxWeight, WeigherType weigher)
+        : capacity_(maxWeight)
+        , weigher_(std::move(weigher))
+        , memCold_(capacity_)
+        , entries_(0)
+        , countHot_(0)
+        , countCold_(0)
+        , countTest_(0)
+        , handHot_(NodePoolType::kNull)
+        , handCold_(NodePoolType::kNull)
+        , handTest_(NodePoolType::kNull)
+        , coldHandRunning_(false)
+    {}
+
+    ~ClockProCache() override = default;
+
+    void put(Key key, Value value) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        // 容量可能被 setCapacity 调整，在锁内检查
+        if (capacity_ == 0) {
+            return;
+        }
+        expireLocked();
+        putLocked(std::move(key), std::move(value), 0);
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        if (capacity_ == 0) {
+            return;
+        }
+        expireLocked();
+        putLocked(std::move(key), std::move(value), expiryDeadline(ttl));
+    }
+
+    bool get(Key key, Value& value) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Get);
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        bool hit = getLocked(key, value);
+        this->stats_.addConcurrent(hit ? CacheEvent::Hit : CacheEvent::Miss);
+        return hit;
+    }
+
+    Value get(Key key) override
+    {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* found) override
+    {
+        return getMany(keys, nullptr, count, values, found);
+    }
+
+    void putMany(const Key* keys, const Value* values, size_t count) override
+    {
+        putMany(keys, nullptr, count, values);
+    }
+
+    // 只处理 positions 指定的下标（为空时为 0..count-1），整批只加一次锁
+    size_t getMany(const Key* keys, const uint32_t* positions, size_t count, Value* values, bool* found)
+    {
+        size_t hits = 0;
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (size_t i = 0; i < count; ++i) {
+            size_t pos = positions ? positions[i] : i;
+            found[pos] = getLocked(keys[pos], values[pos]);
+            hits += found[pos] ? 1 : 0;
+        }
+        this->stats_.addConcurrent(CacheEvent::Hit, hits);
+        this->stats_.addConcurrent(CacheEvent::Miss, count - hits);
+        return hits;
+    }
+
+    void putMany(const Key* keys, const uint32_t* positions, size_t count, const Value* values)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (capacity_ == 0) {
+            return;
+        }
+        expireLocked();
+        for (size_t i = 0; i < count; ++i) {
+            size_t pos = positions ? positions[i] : i;
+            putLocked(keys[pos], values[pos], 0);
+        }
+    }
+
+    size_t purgeExpired() override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        return expireLocked();
+    }
+
+    size_t size() override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return entries_;
+    }
+
+    size_t weightedSize() override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return countHot_ + countCold_;
+    }
+
+    size_t capacity()
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    // 调整驻留结点的容量，缩小时立即淘汰到新容量以内，冷页目标容量与测试页一并收缩（见 ShardRebalancer.h）
+    void setCapacity(size_t capacity)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        capacity_ = capacity;
+        memCold_ = std::min(memCold_, capacity_);
+        evict(0);
+        while (countTest_ > testCapacity()) {
+            runHandTest();
+        }
+    }
+
+    // 分片迁移（见 ShardRouter.h 中的 migrateEntries）：沿环从最早插入的结点开始，
+    // 把 pred(key) 为 true 的驻留条目移出本缓存交给 sink；已过期的条目与 pred 为 true 的测试页直接丢弃。返回移出的条目数
+    template<typename Pred, typename Sink>
+    size_t extractIf(Pred pred, Sink sink)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        std::vector<NodeIndex> ring;
+        ring.reserve(nodeMap_.size());
+        if (handHot_ != NodePoolType::kNull) {
+            NodeIndex idx = handHot_;
+            do {
+                ring.push_back(idx);
+                idx = next(idx);
+            } while (idx != handHot_);
+        }
+
+        size_t extracted = 0;
+        for (NodeIndex idx : ring) {
+            NodeType& node = pool_[idx];
+            if (node.type_ == Type::Test) {
+                if (pred(node.key_)) {
+                    metaDel(idx);
+                    pool_.release(idx);
+                    --countTest_;
+                }
+            } else if (wheel_.expired(node.timer_)) {
+                removeResident(idx);
+            } else if (pred(node.key_)) {
+                uint64_t deadline = node.timer_ == TimerWheel<NodeIndex>::kNone ? 0 : wheel_.deadline(node.timer_);
+                residentCount(node.type_) -= weightOf(idx);
+                --entries_;
+                wheel_.cancel(node.timer_);
+                metaDel(idx);
+                sink(ShardEntry<Key, Value>{std::move(node.key_), std::move(node.value_), deadline, 1});
+                pool_.release(idx);
+                ++extracted;
+            }
+        }
+        return extracted;
+    }
+
+    // 接收迁移来的条目，作为冷页写入；本缓存中已驻留的 key 保留现有的值，是测试页的按测试期内再次访问处理
+    void adopt(std::vector<ShardEntry<Key, Value>>& entries)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (auto& entry : entries) {
+            if (capacity_ == 0) {
+                break;
+            }
+            auto it = nodeMap_.find(entry.key);
+            if (it == nodeMap_.end() || pool_[it->second].type_ == Type::Test) {
+                putLocked(std::move(entry.key), std::move(entry.value), entry.deadline);
+            }
+        }
+    }
+
+private:
+    size_t weightOf(NodeIndex idx) const { return weighEntry(weigher_, pool_[idx].key_, pool_[idx].value_); }
+
+    size_t& residentCount(Type type) { return type == Type::Hot ? countHot_ : countCold_; }
+
+    // 测试页上限：按条目计时与容量相同，按权重计时与驻留条目数相同。
+    // 至少为 1：setCapacity(0) 淘汰时冷指针所在的结点不会被测试指针回收，环不会在指针转动中途变空
+    size_t testCapacity() const { return std::max<size_t>(1, weigher_ ? entries_ : capacity_); }
+
+    // 冷页目标容量每次调整的幅度：按条目计时为 1，按权重计时取驻留条目的平均权重
+    size_t adaptStep() const
+    {
+        return entries_ == 0 ? 1 : std::max<size_t>(1, (countHot_ + countCold_) / entries_);
+    }
+
+    // deadline 为 0 表示不过期；过期时间先于淘汰设好，结点随后被淘汰时定时器一并取消
+    template<typename K, typename V>
+    void putLocked(K&& key, V&& value, uint64_t deadline)
+    {
+        this->stats_.add(CacheEvent::Put);
+        size_t weight = weighEntry(weigher_, key, value);
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) {
+            if (weight > capacity_) {
+                return;
+            }
+            NodeIndex idx = pool_.allocate(std::forward<K>(key), std::forward<V>(value));
+            metaAdd(idx, weight);
+            countCold_ += weight;
+            ++entries_;
+            setExpiry(idx, deadline);
+            return;
+        }
+
+        NodeIndex idx = it->second;
+        NodeType& node = pool_[idx];
+        if (node.type_ != Type::Test) {
+            setExpiry(idx, deadline);
+            size_t& count = residentCount(node.type_);
+            count -= weightOf(idx);
+            node.value_ = std::forward<V>(value);
+            count += weight;
+            if (weight > capacity_) {
+                // 单个条目就超过容量：直接移除
+                removeResident(idx);
+                return;
+            }
+            node.referenced_.store(true, std::memory_order_relaxed);
+            evict(0);
+            return;
+        }
+
+        // 测试期内再次访问：扩大冷页目标容量，并把它作为热页重新插入
+        this->stats_.add(CacheEvent::GhostHit);
+        this->stats_.add(CacheEvent::CapacityShift);
+        --countTest_;
+        metaDel(idx);
+        if (weight > capacity_) {
+            pool_.release(idx);
+            return;
+        }
+        memCold_ = std::min(capacity_, memCold_ + weight);
+        node.referenced_.store(false, std::memory_order_relaxed);
+        node.value_ = std::forward<V>(value);
+        node.type_ = Type::Hot;
+        metaAdd(idx, weight);
+        countHot_ += weight;
+        ++entries_;
+        setExpiry(idx, deadline);
+    }
+
+    void setExpiry(NodeIndex idx, uint64_t deadline)
+    {
+        uint32_t& timer = pool_[idx].timer_;
+        if (deadline == 0) {
+            wheel_.cancel(timer);
+            timer = TimerWheel<NodeIndex>::kNone;
+        } else {
+            timer = wheel_.reschedule(timer, idx, deadline);
+        }
+    }
+
+    // 过期的驻留结点直接移除，不转为测试页：它不是因为没被访问而淘汰的
+    size_t expireLocked()
+    {
+        if (wheel_.empty()) {
+            return 0;
+        }
+        size_t expired = wheel_.advance(expiryNow(), [this](NodeIndex idx) {
+            pool_[idx].timer_ = TimerWheel<NodeIndex>::kNone;
+            removeResident(idx);
+        });
+        this->stats_.add(CacheEvent::Expiration, expired);
+        return expired;
+    }
+
+    void removeResident(NodeIndex idx)
+    {
+        residentCount(pool_[idx].type_) -= weightOf(idx);
+        --entries_;
+        wheel_.cancel(pool_[idx].timer_);
+        metaDel(idx);
+        pool_.release(idx);
+    }
+
+    bool getLocked(const Key& key, Value& value)
+    {
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) {
+            return false;
+        }
+        NodeType& node = pool_[it->second];
+        if (node.type_ == Type::Test || wheel_.expired(node.timer_)) {
+            return false;
+        }
+        node.referenced_.store(true, std::memory_order_relaxed);
+        value = node.value_;
+        return true;
+    }
+
+    NodeIndex next(NodeIndex idx) { return pool_[idx].next_; }
+    NodeIndex prev(NodeIndex idx) { return pool_[idx].prev_; }
+
+    // 插入到热指针之前，即环中"最新"的位置；插入前先为 weight 腾出空间
+    void metaAdd(NodeIndex idx, size_t weight)
+    {
+        evict(weight);
+        nodeMap_[pool_[idx].key_] = idx;
+
+        NodeType& node = pool_[idx];
+        if (handHot_ == NodePoolType::kNull) {
+            node.prev_ = idx;
+            node.next_ = idx;
+            handHot_ = handCold_ = handTest_ = idx;
+        } else {
+            NodeType& at = pool_[handHot_];
+            node.next_ = handHot_;
+            node.prev_ = at.prev_;
+            pool_[at.prev_].next_ = idx;
+            at.prev_ = idx;
+        }
+        if (handCold_ == handHot_) {
+            handCold_ = prev(handCold_);
+        }
+    }
+
+    // 从环和索引中摘除结点，指向它的指针回退一格；结点本身由调用者决定是否释放
+    void metaDel(NodeIndex idx)
+    {
+        NodeType& node = pool_[idx];
+        nodeMap_.erase(node.key_);
+        if (node.next_ == idx) {
+            handHot_ = handCold_ = handTest_ = NodePoolType::kNull;
+            return;
+        }
+        if (idx == handHot_) handHot_ = node.prev_;
+        if (idx == handCold_) handCold_ = node.prev_;
+        if (idx == handTest_) handTest_ = node.prev_;
+        pool_[node.prev_].next_ = node.next_;
+        pool_[node.next_].prev_ = node.prev_;
+    }
+
+    void evict(size_t incoming)
+    {
+        while (countHot_ + countCold_ + incoming > capacity_ && entries_ > 0) {
+            // 按权重计时热页可能占满到放不下新条目，此时先由热指针降级出冷页
+            if (countCold_ == 0) {
+                runHandHot();
+            } else {
+                runHandCold();
+            }
+        }
+    }
+
+    void runHandCold()
+    {
+        bool wasRunning = coldHandRunning_;
+        coldHandRunning_ = true;
+        NodeType& node = pool_[handCold_];
+        if (node.type_ == Type::Cold) {
+            size_t weight = weightOf(handCold_);
+            if (node.referenced_.load(std::memory_order_relaxed)) {
+                node.type_ = Type::Hot;
+                node.referenced_.store(false, std::memory_order_relaxed);
+                countCold_ -= weight;
+                countHot_ += weight;
+            } else {
+                // 冷页淘汰后转为测试页，只保留 key，值立即释放
+                node.type_ = Type::Test;
+                releaseValue(node.value_);
+                wheel_.cancel(node.timer_);
+                node.timer_ = TimerWheel<NodeIndex>::kNone;
+                countCold_ -= weight;
+                --entries_;
+                ++countTest_;
+                this->stats_.add(CacheEvent::Eviction);
+                while (testCapacity() < countTest_) {
+                    runHandTest();
+                }
+            }
+        }
+        handCold_ = next(handCold_);
+        while (capacity_ - memCold_ < countHot_) {
+            runHandHot();
+        }
+        coldHandRunning_ = wasRunning;
+    }
+
+    void runHandHot()
+    {
+        if (handHot_ == handTest_) {
+            runHandTest();
+        }
+        NodeType& node = pool_[handHot_];
+        if (node.type_ == Type::Hot) {
+            if (node.referenced_.load(std::memory_order_relaxed)) {
+                node.referenced_.store(false, std::memory_order_relaxed);
+            } else {
+                size_t weight = weightOf(handHot_);
+                node.type_ = Type::Cold;
+                countHot_ -= weight;
+                countCold_ += weight;
+            }
+        }
+        handHot_ = next(handHot_);
+    }
+
+    // 测试期结束仍未被访问的测试页直接回收，同时缩小冷页目标容量
+    void runHandTest()
+    {
+        // 冷指针正在运行时不再递归推动它：环很小、三根指针重合时
+        // 冷 -> 热 -> 测试 -> 冷 的递归会永远轮不到热指针自己前进
+        if (handTest_ == handCold_ && !coldHandRunning_) {
+            runHandCold();
+        }
+        NodeIndex idx = handTest_;
+        if (pool_[idx].type_ == Type::Test) {
+            NodeIndex prevIdx = prev(idx);
+            metaDel(idx);
+            pool_.release(idx);
+            handTest_ = prevIdx;
+            --countTest_;
+            size_t step = adaptStep();
+            memCold_ = memCold_ > step ? memCold_ - step : 1;
+            this->stats_.add(CacheEvent::CapacityShift);
+        }
+        if (handTest_ != NodePoolType::kNull) {
+            handTest_ = next(handTest_);
+        }
+    }
+
+private:
+    size_t            capacity_;   // 驻留结点（冷 + 热）的权重上限，测试页另有上限（见 testCapacity）
+    WeigherType       weigher_;
+    size_t            memCold_;    // 冷页目标容量，随测试页命中/过期自适应调整
+    size_t            entries_;    // 驻留结点个数
+    size_t            countHot_;   // 热页权重之和
+    size_t            countCold_;  // 冷页权重之和
+    size_t            countTest_;  // 测试页个数
+    NodeIndex         handHot_;
+    NodeIndex         handCold_;
+    NodeIndex         handTest_;
+    bool              coldHandRunning_;
+    NodeMap           nodeMap_;
+    NodePoolType      pool_;
+    TimerWheel<NodeIndex> wheel_;  // 设置了过期时间的驻留结点
+    std::shared_mutex mutex_;
+};
@@ -0,0 +1,476 @@
+#pragma once
+#include "HashMix.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLAT_HASH_MAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace flat_detail
+{
+
+// 控制字节：0..127 表示该槽位已占用，存放哈希值的低 7 位（H2）；负值表示空闲
+constexpr int8_t kEmpty = -128;
+constexpr int8_t kDeleted = -2;
+constexpr size_t kGroupWidth = 16;
+
+inline unsigned lowestBit(uint32_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+    unsigned i = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        ++i;
+    }
+    return i;
+#endif
+}
+
+// 一组 16 个控制字节，一次比较得到组内所有匹配槽位的位掩码
+class Group
+{
+public:
+    explicit Group(const int8_t* ctrl)
+    {
+#ifdef FLAT_HASH_MAP_SSE2
+        ctrl_ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+        std::memcpy(ctrl_, ctrl, kGroupWidth);
+#endif
+    }
+
+    uint32_t match(int8_t h2) const
+    {
+#ifdef FLAT_HASH_MAP_SSE2
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i) {
+            mask |= static_cast<uint32_t>(ctrl_[i] == h2) << i;
+        }
+        return mask;
+#endif
+    }
+
+    uint32_t matchEmpty() const { return match(kEmpty); }
+
+    // 空闲与墓碑的符号位都为 1
+    uint32_t matchEmptyOrDeleted() const
+    {
+#ifdef FLAT_HASH_MAP_SSE2
+        return static_cast<uint32_t>(_mm_movemask_epi8(ctrl_));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i) {
+            mask |= static_cast<uint32_t>(ctrl_[i] < 0) << i;
+        }
+        return mask;
+#endif
+    }
+
+private:
+#ifdef FLAT_HASH_MAP_SSE2
+    __m128i ctrl_;
+#else
+    int8_t ctrl_[kGroupWidth];
+#endif
+};
+
+template<typename T, typename = void>
+struct IsTransparent : std::false_type {};
+
+template<typename T>
+struct IsTransparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+
+} // namespace flat_detail
+
+// 索引默认使用的哈希与比较。Key 为 std::string 时两者都是透明的（is_transparent），
+// 可以直接用 std::string_view / const char* 查找而不构造 std::string；
+// 哈希值与 std::hash<std::string> 相同，分片选择等处混用两者结果一致
+template<typename Key>
+struct LookupHash : std::hash<Key> {};
+
+template<>
+struct LookupHash<std::string>
+{
+    using is_transparent = void;
+
+    size_t operator()(std::string_view key) const { return std::hash<std::string_view>()(key); }
+};
+
+template<typename Key>
+struct LookupEqual : std::equal_to<Key> {};
+
+template<>
+struct LookupEqual<std::string> : std::equal_to<> {};
+
+// Swiss table 风格的开放寻址哈希表：控制字节与键值对各自连续存放，键值内联在槽位数组中，
+// 插入不再逐个分配结点。查找按 16 个槽位一组探测，先用 H2 在组内做一次 SIMD 比较，
+// 遇到含空槽的组即可确定 key 不存在。删除时若所在组仍有空槽则直接置空（没有探测序列会越过该组），
+// 否则留下墓碑；墓碑占用的增长额度在下一次重建时回收，频繁淘汰不会让表无限膨胀。
+// 接口是缓存用到的 std::unordered_map 子集；任何插入都可能使迭代器失效。
+template<typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using size_type = size_t;
+
+    template<bool Const>
+    class IteratorBase
+    {
+    public:
+        using Pointer = typename std::conditional<Const, const value_type*, value_type*>::type;
+        using Reference = typename std::conditional<Const, const value_type&, value_type&>::type;
+
+        IteratorBase() : ctrl_(nullptr), slot_(nullptr), end_(nullptr) {}
+        IteratorBase(const int8_t* ctrl, Pointer slot, const int8_t* end)
+            : ctrl_(ctrl), slot_(slot), end_(end)
+        {
+            skipFree();
+        }
+
+        // 允许 iterator 隐式转换为 const_iterator
+        template<bool C = Const, typename = typename std::enable_if<C>::type>
+        IteratorBase(const IteratorBase<false>& other)
+            : ctrl_(other.ctrl_), slot_(other.slot_), end_(other.end_)
+        {}
+
+        Reference operator*() const { return *slot_; }
+        Pointer operator->() const { return slot_; }
+
+        IteratorBase& operator++()
+        {
+            ++ctrl_;
+            ++slot_;
+            skipFree();
+            return *this;
+        }
+
+        bool operator==(const IteratorBase& other) const { return slot_ == other.slot_; }
+        bool operator!=(const IteratorBase& other) const { return slot_ != other.slot_; }
+
+    private:
+        void skipFree()
+        {
+            while (ctrl_ != end_ && *ctrl_ < 0) {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+        const int8_t* ctrl_;
+        Pointer       slot_;
+        const int8_t* end_;
+
+        friend class FlatHashMap;
+        friend class IteratorBase<!Const>;
+    };
+
+    using iterator = IteratorBase<false>;
+    using const_iterator = IteratorBase<true>;
+
+    FlatHashMap()
+        : ctrl_(nullptr)
+        , slots_(nullptr)
+        , capacity_(0)
+        , size_(0)
+        , growthLeft_(0)
+    {}
+
+    ~FlatHashMap()
+    {
+        destroyAll();
+        deallocate(ctrl_, slots_, capacity_);
+    }
+
+    FlatHashMap(const FlatHashMap&) = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+    iterator begin() { return iterator(ctrl_, slots_, ctrl_ + capacity_); }
+    iterator end() { return iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_); }
+    const_iterator begin() const { return const_iterator(ctrl_, slots_, ctrl_ + capacity_); }
+    const_iterator end() const { return const_iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    iterator find(const Key& key) { return iteratorAt(findIndex(key)); }
+
+    // 异构查找：Hash 与 KeyEqual 都是透明的时候，可以用与 Key 可比较的其他类型查找
+    template<typename K, typename H = Hash, typename E = KeyEqual,
+             typename = typename std::enable_if<flat_detail::IsTransparent<H>::value &&
+                                                flat_detail::IsTransparent<E>::value>::type>
+    iterator find(const K& key) { return iteratorAt(findIndex(key)); }
+
+    const_iterator find(const Key& key) const
+    {
+        size_t index = findIndex(key);
+        return const_iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+    }
+
+    size_t count(const Key& key) const { return findIndex(key) != capacity_ ? 1 : 0; }
+
+    T& operator[](const Key& key)
+    {
+        return emplace(key, T()).first->second;
+    }
+
+    template<typename K, typename V>
+    std::pair<iterator, bool> emplace(K&& key, V&& value)
+    {
+        const Key& k = key;     // 其他类型的参数先转换成 Key，与表中已有的 key 比较
+        uint64_t hash = hashOf(k);
+        size_t index = findIndex(k, hash);
+        if (index != capacity_) {
+            return {iteratorAt(index), false};
+        }
+        index = prepareInsert(hash);
+        new (slots_ + index) value_type(std::forward<K>(key), std::forward<V>(value));
+        commitInsert(index, hash);
+        return {iteratorAt(index), true};
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) { return emplace(value.first, value.second); }
+
+    size_t erase(const Key& key)
+    {
+        size_t index = findIndex(key);
+        if (index == capacity_) {
+            return 0;
+        }
+        eraseAt(index);
+        return 1;
+    }
+
+    void erase(const_iterator it) { eraseAt(static_cast<size_t>(it.slot_ - slots_)); }
+    void erase(iterator it) { eraseAt(static_cast<size_t>(it.slot_ - slots_)); }
+
+    void clear()
+    {
+        destroyAll();
+        if (capacity_) {
+            std::memset(ctrl_, flat_detail::kEmpty, capacity_);
+        }
+        size_ = 0;
+        growthLeft_ = maxLoad(capacity_);
+    }
+
+    // 预留至少能容纳 n 个元素而不触发重建的空间
+    void reserve(size_t n)
+    {
+        size_t capacity = capacity_ ? capacity_ : flat_detail::kGroupWidth;
+        while (maxLoad(capacity) < n) {
+            capacity <<= 1;
+        }
+        if (capacity != capacity_) {
+            rehash(capacity);
+        }
+    }
+
+private:
+    static size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+    template<typename K>
+    uint64_t hashOf(const K& key) const { return mixHash(static_cast<uint64_t>(hasher_(key))); }
+
+    static int8_t h2Of(uint64_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+
+    iterator iteratorAt(size_t index) { return iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_); }
+
+    template<typename K>
+    size_t findIndex(const K& key) const { return capacity_ ? findIndex(key, hashOf(key)) : capacity_; }
+
+    // 按组做三角数探测，组数为 2 的幂时会遍历所有组；找不到时返回 capacity_
+    template<typename K>
+    size_t findIndex(const K& key, uint64_t hash) const
+    {
+        if (capacity_ == 0) {
+            return 0;
+        }
+        size_t groupMask = capacity_ / flat_detail::kGroupWidth - 1;
+        size_t group = (hash >> 7) & groupMask;
+        int8_t h2 = h2Of(hash);
+        for (size_t step = 1;; ++step) {
+            size_t base = group * flat_detail::kGroupWidth;
+            flat_detail::Group g(ctrl_ + base);
+            for (uint32_t mask = g.match(h2); mask; mask &= mask - 1) {
+                size_t index = base + flat_detail::lowestBit(mask);
+                if (equal_(slots_[index].first, key)) {
+                    return index;
+                }
+            }
+            if (g.matchEmpty()) {
+                return capacity_;
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    // 探测序列上第一个空闲或墓碑槽位
+    size_t findFreeSlot(uint64_t hash) const
+    {
+        size_t groupMask = capacity_ / flat_detail::kGroupWidth - 1;
+        size_t group = (hash >> 7) & groupMask;
+        for (size_t step = 1;; ++step) {
+            size_t base = group * flat_detail::kGroupWidth;
+            uint32_t mask = flat_detail::Group(ctrl_ + base).matchEmptyOrDeleted();
+            if (mask) {
+                return base + flat_detail::lowestBit(mask);
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    // 找到插入位置，必要时先重建；槽位在 commitInsert 之前仍标记为空闲，构造抛异常时表保持一致
+    size_t prepareInsert(uint64_t hash)
+    {
+        if (capacity_ == 0) {
+            rehash(flat_detail::kGroupWidth);
+        }
+        size_t index = findFreeSlot(hash);
+        if (growthLeft_ == 0 && ctrl_[index] == flat_detail::kEmpty) {
+            // 墓碑占了超过一半的额度时原地清理，否则扩容一倍
+            rehash(size_ * 2 < maxLoad(capacity_) ? capacity_ : capacity_ * 2);
+            index = findFreeSlot(hash);
+        }
+        return index;
+    }
+
+    void commitInsert(size_t index, uint64_t hash)
+    {
+        if (ctrl_[index] == flat_detail::kEmpty) {
+            --growthLeft_;
+        }
+        ctrl_[index] = h2Of(hash);
+        ++size_;
+    }
+
+    void eraseAt(size_t index)
+    {
+        slots_[index].~value_type();
+        --size_;
+        size_t base = index / flat_detail::kGroupWidth * flat_detail::kGroupWidth;
+        if (flat_detail::Group(ctrl_ + base).matchEmpty()) {
+            ctrl_[index] = flat_detail::kEmpty;
+            ++growthLeft_;
+        } else {
+            ctrl_[index] = flat_detail::kDeleted;
+        }
+    }
+
+    void rehash(size_t newCapacity)
+    {
+        int8_t* oldCtrl = ctrl_;
+        value_type* oldSlots = slots_;
+        size_t oldCapacity = capacity_;
+
+        ctrl_ = new int8_t[newCapacity];
+        std::memset(ctrl_, flat_detail::kEmpty, newCapacity);
+        slots_ = std::allocator<value_type>().allocate(newCapacity);
+        capacity_ = newCapacity;
+        growthLeft_ = maxLoad(newCapacity) - size_;
+
+        for (size_t i = 0; i < oldCapacity; ++i) {
+            if (oldCtrl[i] >= 0) {
+                uint64_t hash = hashOf(oldSlots[i].first);
+                size_t index = findFreeSlot(hash);
+                new (slots_ + index) value_type(std::move(oldSlots[i]));
+                ctrl_[index] = h2Of(hash);
+                oldSlots[i].~value_type();
+            }
+        }
+        deallocate(oldCtrl, oldSlots, oldCapacity);
+    }
+
+    void destroyAll()
+    {
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] >= 0) {
+                slots_[i].~value_type();
+            }
+        }
+    }
+
+    static void deallocate(int8_t* ctrl, value_type* slots, size_t capacity)
+    {
+        delete[] ctrl;
+        if (slots) {
+            std::allocator<value_type>().deallocate(slots, capacity);
+        }
+    }
+
+private:
+    int8_t*     ctrl_;       // 控制字节，capacity_ 个，按 16 个一组
+    value_type* slots_;      // 键值对，与控制字节一一对应
+    size_t      capacity_;   // 0 或 16 的 2 的幂倍数
+    size_t      size_;
+    size_t      growthLeft_; // 还能填入多少个空槽（不含墓碑复用）就需要重建
+    Hash        hasher_;
+    KeyEqual    equal_;
+};
+
+// 缓存策略的索引选择：以模板参数传给 LruCache / LfuCache / ArcCache 等，
+// 决定 key 到结点的映射使用哪种哈希表
+// find(map, key) 用与 Key 可比较的类型（如 std::string_view）查找
+struct StdIndex
+{
+    template<typename K, typename V>
+    using Map = std::unordered_map<K, V, LookupHash<K>, LookupEqual<K>>;
+
+    // 标准库提供异构查找（C++20 起）且哈希与比较都透明时直接用 K 查找；
+    // C++17 的 unordered_map 没有异构查找，其他类型仍需先构造出 Key
+    template<typename Map, typename K>
+    static auto find(Map& map, const K& key)
+    {
+        if constexpr (std::is_same<K, typename Map::key_type>::value) {
+            return map.find(key);
+        }
+#if defined(__cpp_lib_generic_unordered_lookup) && __cpp_lib_generic_unordered_lookup >= 201811L
+        else if constexpr (flat_detail::IsTransparent<typename Map::hasher>::value &&
+                           flat_detail::IsTransparent<typename Map::key_equal>::value) {
+            return map.find(key);
+        }
+#endif
+        else {
+            return map.find(typename Map::key_type(key));
+        }
+    }
+
+    // 一次探测完成查找或插入，返回 (迭代器, 是否新插入)；key 已存在时不构造任何东西
+    template<typename Map, typename K, typename V>
+    static auto tryEmplace(Map& map, K&& key, V&& value)
+    {
+        return map.try_emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+};
+
+struct FlatIndex
+{
+    template<typename K, typename V>
+    using Map = FlatHashMap<K, V, LookupHash<K>, LookupEqual<K>>;
+
+    template<typename Map, typename K>
+    static auto find(Map& map, const K& key) { return map.find(key); }
+
+    // FlatHashMap::emplace 先查找、找不到才构造，本身就只探测一次
+    template<typename Map, typename K, typename V>
+    static auto tryEmplace(Map& map, K&& key, V&& value)
+    {
+        return map.emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+};
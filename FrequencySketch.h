@@ -0,0 +1,145 @@
+#pragma once
+#include "HashMix.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 4 位计数器的 Count-Min 频率草图：每个 uint64_t 存 16 个计数器，每个 key 落在 4 行中各一个计数器上，
+// 估计值取四者最小值。累计记录次数达到采样周期后所有计数器减半，使旧的热度逐渐淡出。
+// 表大小约为容量的一半个 uint64_t，即每个缓存条目约 4 字节；capacity 与采样周期都按条目数计。
+class FrequencySketch
+{
+public:
+    explicit FrequencySketch(size_t capacity) { resize(capacity); }
+
+    // 按 capacity 个条目重新分配，已有的计数全部丢弃
+    void resize(size_t capacity)
+    {
+        size_t words = 8;
+        while (words < capacity / 2) {
+            words <<= 1;
+        }
+        table_.assign(words, 0);
+        mask_ = words - 1;
+        sampleSize_ = std::max<size_t>(10 * capacity, 16);
+        additions_ = 0;
+    }
+
+    // 返回 true 表示本次记录触发了一次整体减半
+    bool increment(uint64_t hash)
+    {
+        uint64_t h = mixHash(hash);
+        bool added = false;
+        for (int i = 0; i < 4; ++i) {
+            added |= incrementAt(indexOf(h, i), counterOf(h, i));
+        }
+        if (added && ++additions_ >= sampleSize_) {
+            reset();
+            return true;
+        }
+        return false;
+    }
+
+    uint32_t frequency(uint64_t hash) const
+    {
+        uint64_t h = mixHash(hash);
+        uint32_t freq = 15;
+        for (int i = 0; i < 4; ++i) {
+            uint64_t word = table_[indexOf(h, i)];
+            freq = std::min<uint32_t>(freq, (word >> (counterOf(h, i) << 2)) & 0xf);
+        }
+        return freq;
+    }
+
+    size_t memoryUsage() const { return table_.size() * sizeof(uint64_t); }
+
+private:
+    size_t indexOf(uint64_t h, int i) const
+    {
+        uint64_t x = (h + 0x9E3779B97F4A7C15ull * static_cast<uint64_t>(i + 1)) * 0xbf58476d1ce4e5b9ull;
+        return static_cast<size_t>(x >> 32) & mask_;
+    }
+
+    static uint32_t counterOf(uint64_t h, int i) { return (h >> (i * 4)) & 0xf; }
+
+    bool incrementAt(size_t index, uint32_t counter)
+    {
+        uint64_t shift = counter << 2;
+        uint64_t mask = 0xfull << shift;
+        if ((table_[index] & mask) == mask) {
+            return false;
+        }
+        table_[index] += 1ull << shift;
+        return true;
+    }
+
+    void reset()
+    {
+        for (auto& word : table_) {
+            word = (word >> 1) & 0x7777777777777777ull;
+        }
+        additions_ /= 2;
+    }
+
+private:
+    std::vector<uint64_t> table_;
+    size_t                mask_;
+    size_t                sampleSize_;
+    size_t                additions_;
+};
+
+// 门卫布隆过滤器：只出现过一次的 key 只在这里留下痕迹，不进入频率草图。
+// 每个缓存条目约 1 字节，随频率草图的减半一起清空。
+class Doorkeeper
+{
+public:
+    explicit Doorkeeper(size_t capacity) { resize(capacity); }
+
+    // 按 capacity 个条目重新分配并清空
+    void resize(size_t capacity)
+    {
+        size_t bits = 64;
+        while (bits < capacity * 8) {
+            bits <<= 1;
+        }
+        bits_.assign(bits / 64, 0);
+        mask_ = bits - 1;
+    }
+
+    bool contains(uint64_t hash) const
+    {
+        uint64_t h = mixHash(hash ^ 0x5bd1e995ull);
+        for (int i = 0; i < 2; ++i) {
+            size_t bit = static_cast<size_t>(h >> (i * 32)) & mask_;
+            if (!(bits_[bit / 64] & (1ull << (bit % 64)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 插入 key，返回插入之前是否已经存在
+    bool put(uint64_t hash)
+    {
+        uint64_t h = mixHash(hash ^ 0x5bd1e995ull);
+        bool present = true;
+        for (int i = 0; i < 2; ++i) {
+            size_t bit = static_cast<size_t>(h >> (i * 32)) & mask_;
+            uint64_t flag = 1ull << (bit % 64);
+            if (!(bits_[bit / 64] & flag)) {
+                present = false;
+                bits_[bit / 64] |= flag;
+            }
+        }
+        return present;
+    }
+
+    void clear() { std::fill(bits_.begin(), bits_.end(), 0); }
+
+    size_t memoryUsage() const { return bits_.size() * sizeof(uint64_t); }
+
+private:
+    std::vector<uint64_t> bits_;
+    size_t                mask_;
+};
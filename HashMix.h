@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+// 64 位哈希的二次混合（murmur3 finalizer）。std::hash 对整数是恒等映射，
+// 直接取低位做下标会让连续 key 高度相关，因此进入各类位表、哈希表之前都先混合一次。
+inline uint64_t mixHash(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// 对数-线性分桶的延迟直方图：每个 2 的幂区间再等分 16 个子桶，相对误差不超过 1/16。
+// 记录只是一次前导零计数加一次自增，没有分配和锁；单写者使用，多线程时每个线程各持一份再 merge。
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kBuckets = 64 * kSubBuckets;
+
+    LatencyHistogram() { reset(); }
+
+    void record(uint64_t value)
+    {
+        ++counts_[bucketOf(value)];
+        ++total_;
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        for (int i = 0; i < kBuckets; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    void reset()
+    {
+        std::fill(counts_, counts_ + kBuckets, 0);
+        total_ = 0;
+        max_ = 0;
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t max() const { return max_; }
+
+    // 第 q 分位（0 < q <= 1）所在桶的上界
+    uint64_t percentile(double q) const
+    {
+        if (total_ == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(q * total_ + 0.5);
+        rank = std::max<uint64_t>(1, std::min(rank, total_));
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return std::min(upperBound(i), max_);
+            }
+        }
+        return max_;
+    }
+
+private:
+    static int bucketOf(uint64_t value)
+    {
+        if (value < kSubBuckets) {
+            return static_cast<int>(value);
+        }
+        int msb = 63 - __builtin_clzll(value);
+        int sub = static_cast<int>((value >> (msb - kSubBits)) & (kSubBuckets - 1));
+        return (msb - kSubBits + 1) * kSubBuckets + sub;
+    }
+
+    static uint64_t upperBound(int bucket)
+    {
+        if (bucket < kSubBuckets) {
+            return static_cast<uint64_t>(bucket);
+        }
+        int msb = bucket / kSubBuckets + kSubBits - 1;
+        uint64_t sub = static_cast<uint64_t>(bucket % kSubBuckets);
+        uint64_t width = 1ull << (msb - kSubBits);
+        return ((kSubBuckets + sub) << (msb - kSubBits)) + width - 1;
+    }
+
+private:
+    uint64_t counts_[kBuckets];
+    uint64_t total_;
+    uint64_t max_;
+};
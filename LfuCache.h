@@ -6,10 +6,20 @@
 #include <unordered_map>
 #include <memory>
 #include <thread>
+#include <algorithm>
 
 #include "Cachepolicy.h"
-
-template<typename Key, typename Value> class LfuCache;
+#include "NodePool.h"
+#include "CacheBatch.h"
+#include "CacheSnapshot.h"
+#include "CacheWeigher.h"
+#include "FlatHashMap.h"
+#include "ShardRebalancer.h"
+#include "ShardRouter.h"
+#include "SingleFlight.h"
+#include "TimerWheel.h"
+
+template<typename Key, typename Value, typename Index = StdIndex> class LfuCache;
 
 template<typename Key, typename Value> 
 class FreqList
@@ -17,103 +27,140 @@ class FreqList
 private:
     struct Node
     {
-        int freq;
+        size_t freq;
         Key key;
         Value value;
-        std::shared_ptr<Node> pre;
-        std::shared_ptr<Node> next;
+        uint32_t pre;
+        uint32_t next;
+        uint32_t timer; // 过期定时器，没有过期时间时为 kNone
 
         Node()
-        :freq(1), pre(nullptr), next(nullptr){}
+        :freq(1), pre(NodePool<Node>::kNull), next(NodePool<Node>::kNull), timer(TimerWheel<uint32_t>::kNone){}
         Node(Key key, Value value)
-        :freq(1), key(key), value(value), pre(nullptr), next(nullptr){}
+        :freq(1), key(std::move(key)), value(std::move(value)), pre(NodePool<Node>::kNull), next(NodePool<Node>::kNull),
+         timer(TimerWheel<uint32_t>::kNone){}
     };
 
-    using NodePtr=std::shared_ptr<Node>;
-    int freq_;
-    NodePtr head_;
-    NodePtr tail_;
+    using Pool = NodePool<Node>;
+    using NodeIndex = typename Pool::Index;
+    size_t freq_;
+    Pool* pool_;
+    NodeIndex head_;
+    NodeIndex tail_;
 public:
-    explicit FreqList(int n) : freq_(n)
-    {
-        head_ = std::make_shared<Node>();
-        tail_ = std::make_shared<Node>();
-        head_->next = tail_;
-        tail_->pre = head_;
-    }
+    FreqList(size_t n, Pool* pool) : freq_(n), pool_(pool), head_(Pool::kNull), tail_(Pool::kNull)
+    {}
     bool isEmpty() const
     {
-      return head_->next == tail_;
+      return head_ == Pool::kNull;
     }
 
-    void addNode(NodePtr node) 
+    void addNode(NodeIndex idx) 
     {
-        if (!node || !head_ || !tail_) 
+        if (idx == Pool::kNull) 
             return;
 
-        node->pre = tail_->pre;
-        node->next = tail_;
-        tail_->pre->next = node;
-        tail_->pre = node;
+        Node& node = (*pool_)[idx];
+        node.pre = tail_;
+        node.next = Pool::kNull;
+        if (tail_ != Pool::kNull)
+            (*pool_)[tail_].next = idx;
+        else
+            head_ = idx;
+        tail_ = idx;
     }
 
-    void removeNode(NodePtr node)
+    void removeNode(NodeIndex idx)
     {
-        if (!node || !head_ || !tail_)
-            return;
-        if (!node->pre || !node->next) 
+        if (idx == Pool::kNull)
             return;
 
-        node->pre->next = node->next;
-        node->next->pre = node->pre;
-        node->pre = nullptr;
-        node->next = nullptr;
+        Node& node = (*pool_)[idx];
+        if (node.pre != Pool::kNull)
+            (*pool_)[node.pre].next = node.next;
+        else
+            head_ = node.next;
+        if (node.next != Pool::kNull)
+            (*pool_)[node.next].pre = node.pre;
+        else
+            tail_ = node.pre;
+        node.pre = Pool::kNull;
+        node.next = Pool::kNull;
     }
 
-    NodePtr getFirstNode() const { return head_->next; }
+    NodeIndex getFirstNode() const { return head_; }
     
-    friend class LfuCache<Key, Value>;
+    template<typename K, typename V, typename I> friend class LfuCache;
 };
 
-template <typename Key, typename Value>
+// Index 决定 key 到结点的映射使用的哈希表，见 FlatHashMap.h 中的 StdIndex / FlatIndex
+template <typename Key, typename Value, typename Index>
 class LfuCache : public CachePolicy<Key, Value>
 {
 public:
     using Node = typename FreqList<Key, Value>::Node;
-    using NodePtr = std::shared_ptr<Node>;
-    using NodeMap = std::unordered_map<Key, NodePtr>;
+    using NodePoolType = NodePool<Node>;
+    using NodeIndex = typename NodePoolType::Index;
+    using NodeMap = typename Index::template Map<Key, NodeIndex>;
+    using FreqListPtr = std::unique_ptr<FreqList<Key, Value>>;
+    using WeigherType = Weigher<Key, Value>;
 
     LfuCache(int capacity, int maxAverageNum = 10)
-    : capacity_(capacity), minFreq_(INT8_MAX), maxAverageNum_(maxAverageNum),
-      curAverageNum_(0), curTotalNum_(0) 
+    : LfuCache(capacity > 0 ? capacity : 0, nullptr, maxAverageNum)
+    {}
+
+    // 按权重计容量：所有条目的 weigher(key, value) 之和不超过 maxWeight
+    LfuCache(size_t maxWeight, WeigherType weigher, int maxAverageNum = 10)
+    : capacity_(maxWeight), weightedSize_(0), weigher_(std::move(weigher)), minFreq_(1),
+      maxAverageNum_(maxAverageNum), curAverageNum_(0), curTotalNum_(0), agingEpoch_(0)
     {}
 
     ~LfuCache() override = default;
 
     void put(Key key, Value value) override
     {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer.locked();
+        // 容量可能被 setCapacity 调整，在锁内检查
         if (capacity_ == 0) {
             return;
         }
+        expireLocked();
+        putLocked(std::move(key), std::move(value), 0);
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
         std::lock_guard<std::mutex> lock(mutex_);
-        auto it= nodeMap_.find(key);
-        if (it != nodeMap_.end()) {
-            it->second->value = value;
-            getInternal(it->second, value);
+        timer.locked();
+        if (capacity_ == 0) {
             return;
         }
-
-        putInternal(key, value);
+        expireLocked();
+        putLocked(std::move(key), std::move(value), expiryDeadline(ttl));
     }
+
     bool get(Key key, Value& value) override
     {
+        StatsTimer timer(this->stats_, CacheStats::Op::Get);
         std::lock_guard<std::mutex> lock(mutex_);
+        timer.locked();
         auto it = nodeMap_.find(key);
-        if (it != nodeMap_.end()) {
-            getInternal(it->second, value);
-            return true;
+        if (it == nodeMap_.end()) {
+            this->stats_.add(CacheEvent::Miss);
+            return false;
         }
-        return false;
+        if (wheel_.expired(pool_[it->second].timer)) {
+            removeEntry(it->second);
+            this->stats_.add(CacheEvent::Expiration);
+            this->stats_.add(CacheEvent::Miss);
+            return false;
+        }
+        getInternal(it->second, value);
+        this->stats_.add(CacheEvent::Hit);
+        return true;
     }
 
     Value get(Key key) override
@@ -123,182 +170,604 @@ public:
         return value;
     }
 
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* found) override
+    {
+        return getMany(keys, nullptr, count, values, found);
+    }
+
+    void putMany(const Key* keys, const Value* values, size_t count) override
+    {
+        putMany(keys, nullptr, count, values);
+    }
+
+    // 只处理 positions 指定的下标（为空时为 0..count-1）。整批只加一次锁，
+    // 先探测哈希表并预取命中的结点，再统一更新频次
+    size_t getMany(const Key* keys, const uint32_t* positions, size_t count, Value* values, bool* found)
+    {
+        constexpr size_t kPipeline = 16;
+        NodeIndex nodes[kPipeline];
+        size_t hits = 0;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t base = 0; base < count; base += kPipeline) {
+            size_t n = std::min(kPipeline, count - base);
+            for (size_t i = 0; i < n; ++i) {
+                size_t pos = positions ? positions[base + i] : base + i;
+                auto it = nodeMap_.find(keys[pos]);
+                nodes[i] = it != nodeMap_.end() ? it->second : NodePoolType::kNull;
+                if (nodes[i] != NodePoolType::kNull) {
+                    pool_.prefetch(nodes[i]);
+                }
+            }
+            for (size_t i = 0; i < n; ++i) {
+                size_t pos = positions ? positions[base + i] : base + i;
+                if (nodes[i] != NodePoolType::kNull && wheel_.expired(pool_[nodes[i]].timer)) {
+                    removeEntry(nodes[i]);
+                    this->stats_.add(CacheEvent::Expiration);
+                    nodes[i] = NodePoolType::kNull;
+                }
+                found[pos] = nodes[i] != NodePoolType::kNull;
+                if (found[pos]) {
+                    getInternal(nodes[i], values[pos]);
+                    ++hits;
+                }
+            }
+        }
+        this->stats_.add(CacheEvent::Hit, hits);
+        this->stats_.add(CacheEvent::Miss, count - hits);
+        return hits;
+    }
+
+    void putMany(const Key* keys, const uint32_t* positions, size_t count, const Value* values)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (capacity_ == 0) {
+            return;
+        }
+        expireLocked();
+        for (size_t i = 0; i < count; ++i) {
+            size_t pos = positions ? positions[i] : i;
+            putLocked(keys[pos], values[pos], 0);
+        }
+    }
+
     void purge()
     {
-        nodeMap_.clear();
-        freqToFreqList_.clear();
+        std::lock_guard<std::mutex> lock(mutex_);
+        purgeLocked();
+    }
+
+    size_t purgeExpired() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return expireLocked();
+    }
+
+    size_t size() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return nodeMap_.size();
+    }
+
+    size_t weightedSize() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return weightedSize_;
+    }
+
+    size_t capacity()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    // 调整容量（权重上限），缩小时立即淘汰到新容量以内。供分片缓存在分片之间转移容量（见 ShardRebalancer.h）
+    void setCapacity(size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        while (weightedSize_ > capacity_ && !nodeMap_.empty()) {
+            kickOut();
+        }
+    }
+
+    // 分片迁移（见 ShardRouter.h 中的 migrateEntries）：按有效频次从低到高，把 pred(key) 为 true 的条目
+    // 连同有效频次移出本缓存交给 sink，已过期的条目直接丢弃。返回移出的条目数
+    template<typename Pred, typename Sink>
+    size_t extractIf(Pred pred, Sink sink)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<size_t> freqs;
+        freqs.reserve(freqToFreqList_.size());
+        for (const auto& pair : freqToFreqList_) {
+            freqs.push_back(pair.first);
+        }
+        std::sort(freqs.begin(), freqs.end());
+        size_t extracted = 0;
+        for (size_t freq : freqs) {
+            auto it = freqToFreqList_.find(freq);
+            NodeIndex node = it != freqToFreqList_.end() ? it->second->getFirstNode() : NodePoolType::kNull;
+            while (node != NodePoolType::kNull) {
+                NodeIndex next = pool_[node].next;
+                Node& n = pool_[node];
+                if (wheel_.expired(n.timer)) {
+                    removeEntry(node);
+                } else if (pred(n.key)) {
+                    uint64_t deadline = n.timer == TimerWheel<NodeIndex>::kNone ? 0 : wheel_.deadline(n.timer);
+                    size_t effective = effectiveFreq(n);
+                    weightedSize_ -= weightOf(node);
+                    removeFromFreqList(node);
+                    nodeMap_.erase(n.key);
+                    decreaseFreqNum(effective);
+                    wheel_.cancel(n.timer);
+                    sink(ShardEntry<Key, Value>{std::move(n.key), std::move(n.value), deadline, effective});
+                    pool_.release(node);
+                    ++extracted;
+                }
+                node = next;
+            }
+        }
+        updateMinFreq();
+        return extracted;
+    }
+
+    // 按原有的有效频次接收迁移来的条目（与快照恢复相同）；本缓存中已有的 key 保留现有的值
+    void adopt(std::vector<ShardEntry<Key, Value>>& entries)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (capacity_ == 0) {
+            return;
+        }
+        for (const auto& entry : entries) {
+            if (nodeMap_.find(entry.key) == nodeMap_.end()) {
+                restoreEntry(entry.key, entry.value, entry.deadline, std::max<size_t>(entry.freq, 1));
+            }
+        }
+        curAverageNum_ = nodeMap_.empty() ? 0 : curTotalNum_ / nodeMap_.size();
+        if (curAverageNum_ > static_cast<size_t>(maxAverageNum_)) {
+            handleOverMaxAverageNum();
+        }
+    }
+
+    // 快照：按有效频次从低到高、同一频次内按进入链表的先后写出 (key, value, 剩余存活时间, 有效频次)，
+    // 已过期的条目跳过。保存的是衰减后的有效频次，恢复后与新进入的条目可以直接比较
+    void saveTo(SnapshotWriter& out);
+    // 用快照替换当前内容，频次与同频次内的淘汰顺序都会还原；数据不完整或类型不符时清空缓存并返回 false
+    bool loadFrom(SnapshotReader& in);
+
+    bool saveSnapshot(const std::string& path)
+    {
+        return saveSections(path, 1, [this](size_t, SnapshotWriter& out) { saveTo(out); });
+    }
+
+    bool loadSnapshot(const std::string& path)
+    {
+        return loadSections(path, 1, [this](size_t, SnapshotReader& in) { return loadFrom(in); });
     }
 
 private:
-    void putInternal(Key key, Value value); // 添加缓存
-    void getInternal(NodePtr node, Value& value); // 获取缓存
+    void purgeLocked(); // 清空所有缓存
+    void restoreEntry(const Key& key, const Value& value, uint64_t deadline, size_t freq); // 按快照中的频次插入一个缓存
+    template<typename K, typename V>
+    void putLocked(K&& key, V&& value, uint64_t deadline); // 写入并设置过期时间，deadline 为 0 表示不过期
+    size_t expireLocked(); // 回收时间轮上已到期的缓存
+    NodeIndex putInternal(Key key, Value value); // 添加缓存，被拒绝时返回 kNull
+    void getInternal(NodeIndex node, Value& value); // 获取缓存
+    NodeIndex updateInternal(NodeIndex node, Value value); // 更新已有缓存的值，被移除时返回 kNull
+    void removeEntry(NodeIndex node); // 移除单个缓存
+
+    size_t weightOf(NodeIndex node) const { return weighEntry(weigher_, pool_[node].key, pool_[node].value); }
 
     void kickOut(); // 移除缓存中的过期数据
 
-    void removeFromFreqList(NodePtr node); // 从频率列表中移除节点
-    void addToFreqList(NodePtr node); // 添加到频率列表
+    void removeFromFreqList(NodeIndex node); // 从频率列表中移除节点
+    void addToFreqList(NodeIndex node); // 添加到频率列表
 
     void addFreqNum(); // 增加平均访问等频率
-    void decreaseFreqNum(int num); // 减少平均访问等频率
+    void decreaseFreqNum(size_t num); // 减少平均访问等频率
     void handleOverMaxAverageNum(); // 处理当前平均访问频率超过上限的情况
     void updateMinFreq();
+    void advanceMinFreq(size_t limit); // 最小频次链表被取空后，向上寻找下一个非空链表
+
+    // 结点中保存的是"未衰减"的频次，减去当前纪元累计的衰减量才是有效频次（最小为 1）
+    size_t agingBase() const { return agingEpoch_ * (maxAverageNum_ / 2); }
+    size_t effectiveFreq(const Node& node) const
+    {
+        size_t base = agingBase();
+        return node.freq > base ? node.freq - base : 1;
+    }
 
 private:
-    int                                            capacity_; // 缓存容量
-    int                                            minFreq_; // 最小访问频次(用于找到最小访问频次结点)
+    size_t                                         capacity_; // 缓存容量（权重上限，未设置 weigher 时即条目数）
+    size_t                                         weightedSize_; // 当前所有缓存的权重之和
+    WeigherType                                    weigher_; // 条目权重，为空时每个条目计 1
+    size_t                                         minFreq_; // 最小访问频次(用于找到最小访问频次结点)
     int                                            maxAverageNum_; // 最大平均访问频次
-    int                                            curAverageNum_; // 当前平均访问频次
-    int                                            curTotalNum_; // 当前访问所有缓存次数总数 
+    size_t                                         curAverageNum_; // 当前平均访问频次
+    size_t                                         curTotalNum_; // 当前所有缓存有效访问频次之和
+    size_t                                         agingEpoch_; // 全局衰减纪元，每次老化加一
     std::mutex                                     mutex_; // 互斥锁
     NodeMap                                        nodeMap_; // key 到 缓存节点的映射
-    std::unordered_map<int, FreqList<Key, Value>*> freqToFreqList_;// 访问频次到该频次链表的映射
+    NodePoolType                                   pool_; // 缓存节点所在的 slab 节点池
+    std::unordered_map<size_t, FreqListPtr>        freqToFreqList_; // 访问频次到该频次链表的映射
+    std::vector<FreqListPtr>                       freeFreqLists_; // 取空后回收、可复用的频次链表
+    TimerWheel<NodeIndex>                          wheel_; // 设置了过期时间的结点
 };
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::getInternal(NodePtr node, Value& value)
+template<typename Key, typename Value, typename Index>
+template<typename K, typename V>
+void LfuCache<Key, Value, Index>::putLocked(K&& key, V&& value, uint64_t deadline)
+{
+    this->stats_.add(CacheEvent::Put);
+    auto it = nodeMap_.find(key);
+    NodeIndex node = it != nodeMap_.end() ? updateInternal(it->second, std::forward<V>(value))
+                                          : putInternal(std::forward<K>(key), std::forward<V>(value));
+    if (node == NodePoolType::kNull) {
+        return;
+    }
+    uint32_t& timer = pool_[node].timer;
+    if (deadline == 0) {
+        wheel_.cancel(timer);
+        timer = TimerWheel<NodeIndex>::kNone;
+    } else {
+        timer = wheel_.reschedule(timer, node, deadline);
+    }
+}
+
+template<typename Key, typename Value, typename Index>
+size_t LfuCache<Key, Value, Index>::expireLocked()
+{
+    if (wheel_.empty()) {
+        return 0;
+    }
+    size_t expired = wheel_.advance(expiryNow(), [this](NodeIndex node) {
+        pool_[node].timer = TimerWheel<NodeIndex>::kNone;
+        removeEntry(node);
+    });
+    this->stats_.add(CacheEvent::Expiration, expired);
+    return expired;
+}
+
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::purgeLocked()
+{
+    nodeMap_.clear();
+    for (auto& pair : freqToFreqList_) {
+        freeFreqLists_.push_back(std::move(pair.second));
+    }
+    freqToFreqList_.clear();
+    pool_.clear();
+    wheel_.clear();
+    minFreq_ = agingBase() + 1;
+    curAverageNum_ = 0;
+    curTotalNum_ = 0;
+    weightedSize_ = 0;
+}
+
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::saveTo(SnapshotWriter& out)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.write(static_cast<uint32_t>(SnapshotKind::Lfu));
+    size_t countAt = out.reserve(sizeof(uint64_t));
+    uint64_t count = 0;
+    uint64_t now = expiryNow();
+
+    std::vector<size_t> freqs;
+    freqs.reserve(freqToFreqList_.size());
+    for (const auto& pair : freqToFreqList_) {
+        freqs.push_back(pair.first);
+    }
+    std::sort(freqs.begin(), freqs.end());
+    for (size_t freq : freqs) {
+        for (NodeIndex node = freqToFreqList_[freq]->getFirstNode(); node != NodePoolType::kNull;
+             node = pool_[node].next) {
+            const Node& n = pool_[node];
+            uint64_t remaining;
+            if (!snapshotRemaining(n.timer == TimerWheel<NodeIndex>::kNone ? 0 : wheel_.deadline(n.timer),
+                                   now, remaining)) {
+                continue;
+            }
+            out.write(n.key);
+            out.write(n.value);
+            out.write(remaining);
+            out.write(static_cast<uint64_t>(effectiveFreq(n)));
+            ++count;
+        }
+    }
+    out.patch(countAt, &count, sizeof(count));
+}
+
+template<typename Key, typename Value, typename Index>
+bool LfuCache<Key, Value, Index>::loadFrom(SnapshotReader& in)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    purgeLocked();
+    uint32_t kind;
+    uint64_t count;
+    if (!in.read(kind) || kind != static_cast<uint32_t>(SnapshotKind::Lfu) || !in.read(count)) {
+        return false;
+    }
+    nodeMap_.reserve(static_cast<size_t>(std::min<uint64_t>(count, capacity_)));
+    for (uint64_t i = 0; i < count; ++i) {
+        Key key;
+        Value value;
+        uint64_t remaining, freq;
+        if (!in.read(key) || !in.read(value) || !in.read(remaining) || !in.read(freq) ||
+            nodeMap_.find(key) != nodeMap_.end()) {
+            purgeLocked();
+            return false;
+        }
+        restoreEntry(key, value, snapshotDeadline(remaining), static_cast<size_t>(std::max<uint64_t>(freq, 1)));
+    }
+    // 快照里的平均频次可能已经超过当前实例的上限（比如调小了 maxAverageNum）
+    curAverageNum_ = nodeMap_.empty() ? 0 : curTotalNum_ / nodeMap_.size();
+    if (curAverageNum_ > static_cast<size_t>(maxAverageNum_)) {
+        handleOverMaxAverageNum();
+    }
+    return true;
+}
+
+// 快照按频次升序写出，依次追加到各频次链表的尾部即还原了同频次内的顺序；
+// 容量比保存时小的话，先进入的低频条目会被随后的条目挤出，和正常运行时的淘汰结果一致
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::restoreEntry(const Key& key, const Value& value, uint64_t deadline, size_t freq)
+{
+    size_t weight = weighEntry(weigher_, key, value);
+    if (weight > capacity_) {
+        return;
+    }
+    while (weightedSize_ + weight > capacity_ && !nodeMap_.empty()) {
+        kickOut();
+    }
+
+    NodeIndex node = pool_.allocate(key, value);
+    weightedSize_ += weight;
+    pool_[node].freq = agingBase() + freq;
+    nodeMap_[key] = node;
+    addToFreqList(node);
+    curTotalNum_ += freq;
+    minFreq_ = std::min(minFreq_, pool_[node].freq);
+    if (deadline != 0) {
+        pool_[node].timer = wheel_.schedule(node, deadline);
+    }
+}
+
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::getInternal(NodeIndex node, Value& value)
 {
-    value = node->value;
+    Node& n = pool_[node];
+    value = n.value;
+    size_t oldFreq = n.freq;
     removeFromFreqList(node);
-    node->freq++;
+    // 惰性老化：上次访问以来错过的衰减在这里一次性补上，频次已衰减到底的结点从 1 重新计数
+    n.freq = std::max(n.freq, agingBase() + 1) + 1;
     addToFreqList(node);
-    if (node->freq - 1 == minFreq_ && freqToFreqList_[node->freq - 1]->isEmpty())
-        minFreq_++;
+    if (oldFreq == minFreq_ && freqToFreqList_.find(oldFreq) == freqToFreqList_.end())
+        advanceMinFreq(n.freq);
     addFreqNum();
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::putInternal(Key key, Value value)
+template<typename Key, typename Value, typename Index>
+typename LfuCache<Key, Value, Index>::NodeIndex LfuCache<Key, Value, Index>::updateInternal(NodeIndex node, Value value)
 {
-    if (nodeMap_.size() == capacity_) {
+    size_t oldWeight = weightOf(node);
+    pool_[node].value = std::move(value);
+    size_t newWeight = weightOf(node);
+    weightedSize_ = weightedSize_ - oldWeight + newWeight;
+    // 单个条目就超过容量时直接移除；值变大后按频次从低到高淘汰，直到总权重重新满足容量
+    if (newWeight > capacity_) {
+        removeEntry(node);
+        return NodePoolType::kNull;
+    }
+    Value out;
+    getInternal(node, out);
+    if (weightedSize_ <= capacity_) {
+        return node;
+    }
+    // 被更新的结点自己也可能是频次最低的，淘汰后重新确认它是否还在
+    Key key = pool_[node].key;
+    while (weightedSize_ > capacity_ && !nodeMap_.empty()) {
         kickOut();
     }
+    auto it = nodeMap_.find(key);
+    return it != nodeMap_.end() ? it->second : NodePoolType::kNull;
+}
 
-    NodePtr node = std::make_shared<Node>(key, value);
-    nodeMap_[key] = node;
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::removeEntry(NodeIndex node)
+{
+    removeFromFreqList(node);
+    nodeMap_.erase(pool_[node].key);
+    decreaseFreqNum(effectiveFreq(pool_[node]));
+    weightedSize_ -= weightOf(node);
+    wheel_.cancel(pool_[node].timer);
+    pool_.release(node);
+}
+
+template<typename Key, typename Value, typename Index>
+typename LfuCache<Key, Value, Index>::NodeIndex LfuCache<Key, Value, Index>::putInternal(Key key, Value value)
+{
+    size_t weight = weighEntry(weigher_, key, value);
+    if (weight > capacity_) {
+        return NodePoolType::kNull;
+    }
+    while (weightedSize_ + weight > capacity_ && !nodeMap_.empty()) {
+        kickOut();
+    }
+
+    // key 在结点和索引中各存一份：先复制进结点，再把参数本身移动进索引
+    NodeIndex node = pool_.allocate(key, std::move(value));
+    weightedSize_ += weight;
+    pool_[node].freq = agingBase() + 1;
+    nodeMap_.emplace(std::move(key), node);
     addToFreqList(node);
     addFreqNum();
-    minFreq_ = std::min(minFreq_, 1);
+    minFreq_ = std::min(minFreq_, pool_[node].freq);
+    return node;
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::kickOut()
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::kickOut()
 {
-    NodePtr node = freqToFreqList_[minFreq_]->getFirstNode();
-    removeFromFreqList(node);
-    nodeMap_.erase(node->key);
-    decreaseFreqNum(node->freq);
+    auto it = freqToFreqList_.find(minFreq_);
+    if (it == freqToFreqList_.end()) {
+        updateMinFreq();
+        it = freqToFreqList_.find(minFreq_);
+        if (it == freqToFreqList_.end()) {
+            return;
+        }
+    }
+    removeEntry(it->second->getFirstNode());
+    this->stats_.add(CacheEvent::Eviction);
+
+    // 紧接着插入的新结点频次为 agingBase() + 1，因此只需在此之下寻找
+    if (freqToFreqList_.find(minFreq_) == freqToFreqList_.end())
+        advanceMinFreq(agingBase() + 1);
 }
 
-template<typename Key,typename Value>
-void LfuCache<Key, Value>::removeFromFreqList(NodePtr node)
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::removeFromFreqList(NodeIndex node)
 {
-    if (!node) {
+    if (node == NodePoolType::kNull) {
         return;
     }
-    auto freq = node->freq;
-    freqToFreqList_[freq]->removeNode(node);
+    auto freq = pool_[node].freq;
+    auto it = freqToFreqList_.find(freq);
+    it->second->removeNode(node);
+    if (it->second->isEmpty()) {
+        freeFreqLists_.push_back(std::move(it->second));
+        freqToFreqList_.erase(it);
+    }
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::addToFreqList(NodePtr node)
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::addToFreqList(NodeIndex node)
 {
-    if (!node) {
+    if (node == NodePoolType::kNull) {
         return;
     }
-    auto freq = node->freq;
-    if (freqToFreqList_.find(freq) == freqToFreqList_.end()) {
-        freqToFreqList_[freq] = new FreqList<Key, Value>(freq);
+    auto freq = pool_[node].freq;
+    auto it = freqToFreqList_.find(freq);
+    if (it == freqToFreqList_.end()) {
+        FreqListPtr list;
+        if (!freeFreqLists_.empty()) {
+            list = std::move(freeFreqLists_.back());
+            freeFreqLists_.pop_back();
+            list->freq_ = freq;
+        } else {
+            list.reset(new FreqList<Key, Value>(freq, &pool_));
+        }
+        it = freqToFreqList_.emplace(freq, std::move(list)).first;
     }
 
-    freqToFreqList_[freq]->addNode(node);
+    it->second->addNode(node);
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::addFreqNum() // 增加平均访问等频率
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::addFreqNum() // 增加平均访问等频率
 {
     curTotalNum_++;
     if (nodeMap_.empty())
         curAverageNum_ = 0;
     else
         curAverageNum_ = curTotalNum_  / nodeMap_.size();
-    if (curAverageNum_ > maxAverageNum_)
+    if (curAverageNum_ > static_cast<size_t>(maxAverageNum_))
     {
         handleOverMaxAverageNum();
     }
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::decreaseFreqNum(int num)
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::decreaseFreqNum(size_t num)
 {
-    curTotalNum_ -= num;
+    curTotalNum_ = curTotalNum_ > num ? curTotalNum_ - num : 0;
     if (nodeMap_.empty()) 
         curAverageNum_ = 0;
     else
         curAverageNum_ = curTotalNum_ / nodeMap_.size();
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::handleOverMaxAverageNum()
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::handleOverMaxAverageNum()
 {
-    if (nodeMap_.empty()) {
+    if (nodeMap_.empty() || maxAverageNum_ / 2 == 0) {
         return;
     }
-    
-    // 当前平均访问频次已经超过了最大平均访问频次，所有结点的访问频次- (maxAverageNum_ / 2)
-    for (auto it = nodeMap_.begin(); it != nodeMap_.end(); ++it) {
-        if (!it->second) {
-            return;
-        }
-        NodePtr node = it->second;
-        removeFromFreqList(node);
-        node->freq = node->freq - (maxAverageNum_ / 2);
-        if (node->freq < 1) {
-            node->freq = 1;
-        }
-        addToFreqList(node);
-    }
 
-    updateMinFreq();
+    // 当前平均访问频次已经超过了最大平均访问频次，所有结点的访问频次- (maxAverageNum_ / 2)。
+    // 这里只推进全局衰减纪元，不遍历结点：各结点在下次被访问或被淘汰时才按纪元折算，
+    // 频次整体平移不改变各链表之间的相对顺序。
+    ++agingEpoch_;
+    this->stats_.add(CacheEvent::AgingRun);
+    size_t decay = nodeMap_.size() * (maxAverageNum_ / 2);
+    curTotalNum_ = curTotalNum_ > decay + nodeMap_.size() ? curTotalNum_ - decay : nodeMap_.size();
+    curAverageNum_ = curTotalNum_ / nodeMap_.size();
 }
 
-template<typename Key, typename Value>
-void LfuCache<Key, Value>::updateMinFreq()
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::advanceMinFreq(size_t limit)
 {
-    minFreq_ = INT8_MAX;
-    for (const auto& pair : freqToFreqList_) {
-        if (pair.second && !pair.second->isEmpty()) {
-            minFreq_ = std::min(minFreq_, INT8_MAX);
-        }
+    // 低于 agingBase() + 1 的频次不会再有新结点进入，因此每个频次值至多被越过一次
+    while (minFreq_ < limit && freqToFreqList_.find(minFreq_) == freqToFreqList_.end()) {
+        ++minFreq_;
     }
-    if (minFreq_ == INT8_MAX) {
-        minFreq_ = 1;
+}
+
+template<typename Key, typename Value, typename Index>
+void LfuCache<Key, Value, Index>::updateMinFreq()
+{
+    if (freqToFreqList_.empty()) {
+        minFreq_ = agingBase() + 1;
+        return;
+    }
+    minFreq_ = SIZE_MAX;
+    for (const auto& pair : freqToFreqList_) {
+        minFreq_ = std::min(minFreq_, pair.first);
     }
 }
 
-template<typename Key, typename Value>
+// 分片 LFU。Router 决定 key 到分片的映射（见 ShardRouter.h），用 ConsistentRouter 时可以在运行时增删分片
+template<typename Key, typename Value, typename Index = StdIndex, typename Router = MixRouter>
 class LfuHashCache 
 {
+    using RouteGuard = RouteReadGuard<Router::kResizable>;
+    using Slice = LfuCache<Key, Value, Index>;
+
 public:
     LfuHashCache(int capacity, size_t sliceNum)
-        : capacity_(capacity)
+        : LfuHashCache(capacity > 0 ? capacity : 0, sliceNum, nullptr)
+    {}
+
+    // 按权重计容量，每个分片分到 ceil(maxWeight / sliceNum) 的权重
+    LfuHashCache(size_t maxWeight, size_t sliceNum, Weigher<Key, Value> weigher)
+        : capacity_(maxWeight)
         , sliceNum_(sliceNum > 0 ? sliceNum : std::max<size_t>(1, std::thread::hardware_concurrency()))
+        , weigher_(std::move(weigher))
+        , router_(sliceNum_)
     {
-        size_t silceSize = std::ceil(capacity / static_cast<double>(sliceNum_));
+        size_t silceSize = std::ceil(maxWeight / static_cast<double>(sliceNum_));
         for (size_t i = 0; i < sliceNum_; i++) {
-            lfuHashCache_.emplace_back(new LfuCache<Key, Value>(silceSize));
+            lfuHashCache_.emplace_back(new Slice(silceSize, weigher_));
         }
     }
     
     void put(Key key, Value value) 
     {
-        size_t sliceIndex = Hash(key) % sliceNum_;
-        lfuHashCache_[sliceIndex]->put(key, value);
+        RouteGuard guard(routeLock_);
+        lfuHashCache_[sliceOf(key)]->put(std::move(key), std::move(value));
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl)
+    {
+        RouteGuard guard(routeLock_);
+        lfuHashCache_[sliceOf(key)]->put(std::move(key), std::move(value), ttl);
     }
 
     bool get(Key key, Value& value) 
     {
-        size_t sliceIndex = Hash(key) % sliceNum_;
-        return lfuHashCache_[sliceIndex]->get(key, value);
+        RouteGuard guard(routeLock_);
+        return lfuHashCache_[sliceOf(key)]->get(key, value);
     }
 
     Value get(Key key) 
@@ -307,13 +776,173 @@ public:
         get(key, value);
         return value;
     }
+
+    // 批量接口：按分片分组后每个分片只加一次锁，结果写入调用方提供的缓冲区
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* found)
+    {
+        RouteGuard guard(routeLock_);
+        size_t hits = 0;
+        forEachShardGroup(keys, count,
+            [this](const Key& key) { return sliceOf(key); },
+            [&](size_t slice, const uint32_t* positions, size_t n) {
+                hits += lfuHashCache_[slice]->getMany(keys, positions, n, values, found);
+            });
+        return hits;
+    }
+
+    void putMany(const Key* keys, const Value* values, size_t count)
+    {
+        RouteGuard guard(routeLock_);
+        forEachShardGroup(keys, count,
+            [this](const Key& key) { return sliceOf(key); },
+            [&](size_t slice, const uint32_t* positions, size_t n) {
+                lfuHashCache_[slice]->putMany(keys, positions, n, values);
+            });
+    }
+
+    // 各分片依次加锁求和，结果不是某一时刻的精确快照
+    size_t size()
+    {
+        RouteGuard guard(routeLock_);
+        size_t total = 0;
+        for (auto& slice : lfuHashCache_) {
+            total += slice->size();
+        }
+        return total;
+    }
+
+    size_t weightedSize()
+    {
+        RouteGuard guard(routeLock_);
+        size_t total = 0;
+        for (auto& slice : lfuHashCache_) {
+            total += slice->weightedSize();
+        }
+        return total;
+    }
+
+    // 逐个分片回收过期条目，同一时刻只持有一个分片的锁
+    size_t purgeExpired()
+    {
+        RouteGuard guard(routeLock_);
+        size_t total = 0;
+        for (auto& slice : lfuHashCache_) {
+            total += slice->purgeExpired();
+        }
+        return total;
+    }
+
+    // 每个分片一个 section，多个线程并行编码 / 解码；分片数或路由与保存时不同时拒绝加载
+    bool saveSnapshot(const std::string& path)
+    {
+        RouteGuard guard(routeLock_);
+        return saveSections(path, sliceNum_,
+            [this](size_t i, SnapshotWriter& out) { lfuHashCache_[i]->saveTo(out); },
+            router_.snapshotLayout());
+    }
+
+    bool loadSnapshot(const std::string& path)
+    {
+        RouteGuard guard(routeLock_);
+        return loadSections(path, sliceNum_,
+            [this](size_t i, SnapshotReader& in) { return lfuHashCache_[i]->loadFrom(in); },
+            router_.snapshotLayout());
+    }
+
+    // 读穿透：未命中时由 loader(key, value) 加载并写回，同一 key 的并发未命中只调用一次 loader，
+    // loader 在分片锁之外执行。语义见 SingleFlight.h
+    template<typename Loader>
+    LoadStatus getOrLoad(const Key& key, Value& value, Loader&& loader,
+                         std::chrono::milliseconds timeout = SingleFlight<Key, Value>::kNoTimeout)
+    {
+        return flights_.getOrLoad(*this, key, value, std::forward<Loader>(loader), timeout);
+    }
+
+    uint64_t coalescedWaiters() const { return flights_.coalescedWaiters(); }
+
+    // 各分片统计之和；每个分片的计数各自读取，不是某一时刻的精确快照
+    CacheStatsSnapshot stats()
+    {
+        RouteGuard guard(routeLock_);
+        CacheStatsSnapshot total;
+        for (auto& slice : lfuHashCache_) {
+            total += slice->stats();
+        }
+        return total;
+    }
+
+    void setStatsSampling(uint32_t every)
+    {
+        RouteGuard guard(routeLock_);
+        for (auto& slice : lfuHashCache_) {
+            slice->setStatsSampling(every);
+        }
+    }
+
+    // 一轮分片间的容量再平衡，总容量不变，同一时刻只持有一个分片的锁。
+    // 需要周期性调用（例如由维护线程与 purgeExpired 一起调用），见 ShardRebalancer.h
+    size_t rebalance(const RebalanceOptions& options = RebalanceOptions())
+    {
+        RouteGuard guard(routeLock_);
+        return rebalancer_.run(lfuHashCache_, options);
+    }
+
+    size_t sliceCount()
+    {
+        RouteGuard guard(routeLock_);
+        return sliceNum_;
+    }
+
+    // 增删分片（仅 Router 可伸缩时可用），语义同 LruHashCache::addSlice / removeSlice；
+    // 迁移的条目保留有效频次
+    size_t addSlice()
+    {
+        static_assert(Router::kResizable, "addSlice requires a resizable router, e.g. ConsistentRouter");
+        std::lock_guard<RouteLock> lock(routeLock_);
+        size_t share = std::ceil(capacity_ / static_cast<double>(sliceNum_ + 1));
+        lfuHashCache_.emplace_back(new Slice(share, weigher_));
+        router_.addSlice();
+        sliceNum_ = router_.slices();
+        size_t moved = migrateEntries<Key, Value>(lfuHashCache_, 0, sliceNum_ - 1, router_,
+                                                  [this](const Key& key) { return Hash(key); });
+        for (size_t i = 0; i + 1 < sliceNum_; ++i) {
+            lfuHashCache_[i]->setCapacity(share);
+        }
+        return moved;
+    }
+
+    size_t removeSlice()
+    {
+        static_assert(Router::kResizable, "removeSlice requires a resizable router, e.g. ConsistentRouter");
+        std::lock_guard<RouteLock> lock(routeLock_);
+        if (sliceNum_ <= 1) {
+            return 0;
+        }
+        size_t share = std::ceil(capacity_ / static_cast<double>(sliceNum_ - 1));
+        for (size_t i = 0; i + 1 < sliceNum_; ++i) {
+            lfuHashCache_[i]->setCapacity(share);
+        }
+        router_.removeSlice();
+        size_t moved = migrateEntries<Key, Value>(lfuHashCache_, sliceNum_ - 1, sliceNum_, router_,
+                                                  [this](const Key& key) { return Hash(key); });
+        lfuHashCache_.pop_back();
+        sliceNum_ = router_.slices();
+        return moved;
+    }
 public:
-    size_t Hash(Key key) {
-        std::hash<Key> hashFunc;  // 确保这里使用了正确的模板类型
+    size_t Hash(const Key& key) {
+        LookupHash<Key> hashFunc;  // 与 std::hash<Key> 结果相同
         return hashFunc(key);
     }
 private:
-    int                                    capacity_;
+    size_t sliceOf(const Key& key) { return router_.route(Hash(key)); }
+
+    size_t                                 capacity_;
     size_t                                 sliceNum_;
-    std::vector<std::unique_ptr<LfuCache<Key, Value>>> lfuHashCache_;
-};
\ No newline at end of file
+    Weigher<Key, Value>                    weigher_;    // 增加分片时构造新分片用
+    Router                                 router_;
+    RouteLock                              routeLock_;  // Router 可伸缩时保护 router_ 与分片数组
+    std::vector<std::unique_ptr<Slice>>    lfuHashCache_;
+    SingleFlight<Key, Value>               flights_;
+    ShardRebalancer                        rebalancer_;
+};
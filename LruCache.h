@@ -1,5 +1,15 @@
 #pragma once
 #include "Cachepolicy.h"
+#include "NodePool.h"
+#include "CacheBatch.h"
+#include "CacheSnapshot.h"
+#include "AccessHistory.h"
+#include "CacheWeigher.h"
+#include "FlatHashMap.h"
+#include "ShardRebalancer.h"
+#include "ShardRouter.h"
+#include "SingleFlight.h"
+#include "TimerWheel.h"
 #include <mutex>
 #include <unordered_map>
 #include <memory>
@@ -7,8 +17,11 @@
 #include <cmath>
 #include <algorithm>
 #include <thread>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 
-template<typename Key, typename Value>class LruCache;
+template<typename Key, typename Value, typename Index = StdIndex> class LruCache;
 
 template<typename Key, typename Value>
 class LruNode
@@ -16,72 +29,126 @@ class LruNode
 private:
     Key key_;
     Value value_;
-    std::shared_ptr<LruNode<Key, Value>> prev_;
-    std::shared_ptr<LruNode<Key, Value>> next_;
-    size_t accessCount_;
+    uint32_t prev_;
+    uint32_t next_;
+    uint32_t accessCount_;
+    uint32_t timer_;    // 过期定时器，没有过期时间时为 kNone
 
 public:
     LruNode(Key key, Value value) 
-        : key_(key)
-        , value_(value)
+        : key_(std::move(key))
+        , value_(std::move(value))
+        , prev_(NodePool<LruNode>::kNull)
+        , next_(NodePool<LruNode>::kNull)
         , accessCount_(1)
-        , prev_(nullptr)
-        , next_(nullptr)
+        , timer_(TimerWheel<uint32_t>::kNone)
     {}
 
-    Key getKey() const { return key_; }
-    Value getValue() const { return value_; }
-    void setValue(Value value) { value_ = value; }
+    const Key& getKey() const { return key_; }
+    const Value& getValue() const { return value_; }
+    void setValue(Value value) { value_ = std::move(value); }
     size_t getAccessCount() const { return accessCount_; }
     void incrementAccessCount() { ++accessCount_; }
 
-    friend class LruCache<Key, Value>;
+    template<typename K, typename V, typename I> friend class LruCache;
 };
 
-template<typename Key, typename Value>
+// Index 决定 key 到结点的映射使用的哈希表，见 FlatHashMap.h 中的 StdIndex / FlatIndex
+template<typename Key, typename Value, typename Index>
 class LruCache : public CachePolicy<Key, Value>
 {
 public:
     using LruNodeType = LruNode<Key, Value>;
-    using NodePtr = std::shared_ptr<LruNodeType>;
-    using NodeMap = std::unordered_map<Key, NodePtr>;
-    
-    LruCache(int capacity) : capacity_(capacity)
+    using NodePoolType = NodePool<LruNodeType>;
+    using NodeIndex = typename NodePoolType::Index;
+    using NodeMap = typename Index::template Map<Key, NodeIndex>;
+    using WeigherType = Weigher<Key, Value>;
+
+    LruCache(int capacity) : LruCache(capacity > 0 ? capacity : 0, nullptr) {}
+
+    // 按权重计容量：所有条目的 weigher(key, value) 之和不超过 maxWeight
+    LruCache(size_t maxWeight, WeigherType weigher)
+        : capacity_(maxWeight)
+        , weightedSize_(0)
+        , weigher_(std::move(weigher))
     {
-        dummyHead_ = std::make_shared<LruNodeType>(Key(), Value());
-        dummyTail_ = std::make_shared<LruNodeType>(Key(), Value());
-        dummyHead_->next_ = dummyTail_;
-        dummyTail_->prev_ = dummyHead_;
+        // 单个哨兵结点构成环形链表：dummy_->next_ 为最久未访问，dummy_->prev_ 为最近访问
+        dummy_ = pool_.allocate(Key(), Value());
+        pool_[dummy_].prev_ = dummy_;
+        pool_[dummy_].next_ = dummy_;
     } 
 
     ~LruCache() = default;
 
     void put(Key key, Value value) override
     {
-        if (capacity_ <= 0) {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer.locked();
+        // 容量可能被 setCapacity 调整，在锁内检查
+        if (capacity_ == 0) {
             return;
         }
-        
+        expireLocked();
+        putLocked(std::move(key), std::move(value), 0);
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
         std::lock_guard<std::mutex> lock(mutex_);
-        auto it = nodeMap_.find(key);
-        if (it != nodeMap_.end()) {
-            updateExistingNode(it->second, value);
+        timer.locked();
+        if (capacity_ == 0) {
             return;
         }
-        
-        addNewNode(key, value);
+        expireLocked();
+        putLocked(std::move(key), std::move(value), expiryDeadline(ttl));
+    }
+
+    // 用 args 构造值后写入。值在加锁之前构造好，锁内只做移动
+    template<typename... Args>
+    void emplace(Key key, Args&&... args)
+    {
+        put(std::move(key), Value(std::forward<Args>(args)...));
     }
 
     bool get(Key key, Value& value) override
     {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    // 异构查找：K 为可以与 Key 比较的类型，例如 Key 为 std::string 时的 std::string_view / const char*。
+    // 使用 FlatIndex 时直接用 K 查找，不构造 Key；StdIndex 仍需先构造一个 Key
+    template<typename K, typename = typename std::enable_if<!std::is_same<K, Key>::value>::type>
+    bool get(const K& key, Value& value)
+    {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    // 命中时在锁内以 const Value& 调用 fn，不复制值；fn 应尽快返回，且不能再访问本缓存。
+    // 与 get 一样会调整访问顺序、回收过期条目
+    template<typename K, typename Fn>
+    bool visit(const K& key, Fn&& fn)
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Get);
         std::lock_guard<std::mutex> lock(mutex_);
-        auto it = nodeMap_.find(key);
-        if (it != nodeMap_.end()) {
-            moveToMostRecent(it->second);
-            value = it->second->getValue();
-            return true;
+        timer.locked();
+        auto it = Index::find(nodeMap_, key);
+        if (it == nodeMap_.end()) {
+            this->stats_.add(CacheEvent::Miss);
+            return false;
+        }
+        NodeIndex node = it->second;
+        if (wheel_.expired(pool_[node].timer_)) {
+            removeEntry(node);
+            this->stats_.add(CacheEvent::Expiration);
+            this->stats_.add(CacheEvent::Miss);
+            return false;
         }
-        return false;
+        moveToMostRecent(node);
+        fn(pool_[node].getValue());
+        this->stats_.add(CacheEvent::Hit);
+        return true;
     }
 
     Value get(Key key) override
@@ -91,132 +158,554 @@ public:
         return value;
     }
 
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* found) override
+    {
+        return getMany(keys, nullptr, count, values, found);
+    }
+
+    void putMany(const Key* keys, const Value* values, size_t count) override
+    {
+        putMany(keys, nullptr, count, values);
+    }
+
+    // 只处理 positions 指定的 count 个下标（为空时为 0..count-1），供分片缓存按分片分组后调用。
+    // 整批只加一次锁：先连续探测哈希表并预取命中的结点，再统一调整链表、拷贝值，
+    // 让多个结点的访存延迟相互重叠。
+    size_t getMany(const Key* keys, const uint32_t* positions, size_t count, Value* values, bool* found)
+    {
+        constexpr size_t kPipeline = 16;
+        NodeIndex nodes[kPipeline];
+        size_t hits = 0;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t base = 0; base < count; base += kPipeline) {
+            size_t n = std::min(kPipeline, count - base);
+            for (size_t i = 0; i < n; ++i) {
+                size_t pos = positions ? positions[base + i] : base + i;
+                auto it = nodeMap_.find(keys[pos]);
+                nodes[i] = it != nodeMap_.end() ? it->second : NodePoolType::kNull;
+                if (nodes[i] != NodePoolType::kNull) {
+                    pool_.prefetch(nodes[i]);
+                }
+            }
+            for (size_t i = 0; i < n; ++i) {
+                size_t pos = positions ? positions[base + i] : base + i;
+                if (nodes[i] != NodePoolType::kNull && wheel_.expired(pool_[nodes[i]].timer_)) {
+                    removeEntry(nodes[i]);
+                    this->stats_.add(CacheEvent::Expiration);
+                    nodes[i] = NodePoolType::kNull;
+                }
+                found[pos] = nodes[i] != NodePoolType::kNull;
+                if (found[pos]) {
+                    moveToMostRecent(nodes[i]);
+                    values[pos] = pool_[nodes[i]].value_;
+                    ++hits;
+                }
+            }
+        }
+        this->stats_.add(CacheEvent::Hit, hits);
+        this->stats_.add(CacheEvent::Miss, count - hits);
+        return hits;
+    }
+
+    void putMany(const Key* keys, const uint32_t* positions, size_t count, const Value* values)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (capacity_ == 0) {
+            return;
+        }
+        expireLocked();
+        for (size_t i = 0; i < count; ++i) {
+            size_t pos = positions ? positions[i] : i;
+            putLocked(keys[pos], values[pos], 0);
+        }
+    }
+
+    // ReadBufferedCache 记录访问用的句柄：结点在池中的下标
+    using AccessToken = NodeIndex;
+
+    // 只读查找，不调整访问顺序也不加锁，允许多个线程并发调用；
+    // 调用方需保证期间没有并发的修改（见 ReadBufferedCache）
+    bool peek(const Key& key, Value& value, AccessToken& token) const
+    {
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end() || wheel_.expired(pool_[it->second].timer_)) {
+            return false;
+        }
+        value = pool_[it->second].value_;
+        token = it->second;
+        return true;
+    }
+
+    // 回放一次访问：把结点移动到最新的位置。结点在记录之后被删除时跳过（清空后哨兵可能落在旧下标上）；
+    // 槽位已复用给别的 key 时算作对新条目的一次访问，与读缓冲丢弃记录一样只让顺序略微近似
+    void touch(AccessToken token)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (token != dummy_ && pool_.live(token)) {
+            moveToMostRecent(token);
+        }
+    }
+
     void remove(Key key) 
     {   
         std::lock_guard<std::mutex> lock(mutex_);
         auto it = nodeMap_.find(key);
         if (it != nodeMap_.end())
         {
-            removeNode(it->second);
-            nodeMap_.erase(it);
+            removeEntry(it->second);
         }
     }
 
+    size_t purgeExpired() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return expireLocked();
+    }
+
+    size_t size() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return nodeMap_.size();
+    }
+
+    size_t weightedSize() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return weightedSize_;
+    }
+
+    size_t capacity()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    // 调整容量（权重上限），缩小时立即淘汰到新容量以内。供分片缓存在分片之间转移容量（见 ShardRebalancer.h）
+    void setCapacity(size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        while (weightedSize_ > capacity_ && !nodeMap_.empty()) {
+            evictLeastRecent();
+        }
+    }
+
+    // 分片迁移（见 ShardRouter.h 中的 migrateEntries）：按最久未访问到最近访问的顺序，
+    // 把 pred(key) 为 true 的条目移出本缓存交给 sink，已过期的条目直接丢弃。返回移出的条目数
+    template<typename Pred, typename Sink>
+    size_t extractIf(Pred pred, Sink sink)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t extracted = 0;
+        NodeIndex node = pool_[dummy_].next_;
+        while (node != dummy_) {
+            NodeIndex next = pool_[node].next_;
+            LruNodeType& n = pool_[node];
+            if (wheel_.expired(n.timer_)) {
+                removeEntry(node);
+            } else if (pred(n.key_)) {
+                uint64_t deadline = n.timer_ == TimerWheel<NodeIndex>::kNone ? 0 : wheel_.deadline(n.timer_);
+                weightedSize_ -= weightOf(node);
+                removeNode(node);
+                wheel_.cancel(n.timer_);
+                nodeMap_.erase(n.key_);
+                sink(ShardEntry<Key, Value>{std::move(n.key_), std::move(n.value_), deadline, 1});
+                pool_.release(node);
+                ++extracted;
+            }
+            node = next;
+        }
+        return extracted;
+    }
+
+    // 按顺序接收迁移来的条目，先接收的先被淘汰；本缓存中已有的 key 保留现有的值
+    void adopt(std::vector<ShardEntry<Key, Value>>& entries)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : entries) {
+            if (capacity_ > 0 && nodeMap_.find(entry.key) == nodeMap_.end()) {
+                putLocked(std::move(entry.key), std::move(entry.value), entry.deadline);
+            }
+        }
+    }
+
+    // 快照：按最久未访问到最近访问的顺序写出 (key, value, 剩余存活时间)，已过期的条目跳过。
+    // Key / Value 的编码见 CacheSnapshot.h 中的 Serializer
+    void saveTo(SnapshotWriter& out)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out.write(static_cast<uint32_t>(SnapshotKind::Lru));
+        size_t countAt = out.reserve(sizeof(uint64_t));
+        uint64_t count = 0;
+        uint64_t now = expiryNow();
+        for (NodeIndex node = pool_[dummy_].next_; node != dummy_; node = pool_[node].next_) {
+            const LruNodeType& n = pool_[node];
+            uint64_t remaining;
+            if (!snapshotRemaining(n.timer_ == TimerWheel<NodeIndex>::kNone ? 0 : wheel_.deadline(n.timer_),
+                                   now, remaining)) {
+                continue;
+            }
+            out.write(n.key_);
+            out.write(n.value_);
+            out.write(remaining);
+            ++count;
+        }
+        out.patch(countAt, &count, sizeof(count));
+    }
+
+    // 用快照替换当前内容：按保存顺序依次插入即还原了访问顺序，容量变小时自然淘汰最旧的条目。
+    // 数据不完整或类型不符时清空缓存并返回 false
+    bool loadFrom(SnapshotReader& in)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clearLocked();
+        uint32_t kind;
+        uint64_t count;
+        if (!in.read(kind) || kind != static_cast<uint32_t>(SnapshotKind::Lru) || !in.read(count)) {
+            return false;
+        }
+        nodeMap_.reserve(static_cast<size_t>(std::min<uint64_t>(count, capacity_)));
+        for (uint64_t i = 0; i < count; ++i) {
+            Key key;
+            Value value;
+            uint64_t remaining;
+            if (!in.read(key) || !in.read(value) || !in.read(remaining)) {
+                clearLocked();
+                return false;
+            }
+            if (capacity_ > 0) {
+                putLocked(std::move(key), std::move(value), snapshotDeadline(remaining));
+            }
+        }
+        return true;
+    }
+
+    bool saveSnapshot(const std::string& path)
+    {
+        return saveSections(path, 1, [this](size_t, SnapshotWriter& out) { saveTo(out); });
+    }
+
+    bool loadSnapshot(const std::string& path)
+    {
+        return loadSections(path, 1, [this](size_t, SnapshotReader& in) { return loadFrom(in); });
+    }
+
+protected:
+    // 只在 key 已存在且未过期时写入（deadline 为 0 表示不过期），返回是否写入；未写入时 value 保持不变。
+    // 供 LruKCache 更新已缓存的条目
+    bool putIfPresent(const Key& key, Value& value, uint64_t deadline)
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer.locked();
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end() || wheel_.expired(pool_[it->second].timer_)) {
+            return false;
+        }
+        putLocked(key, std::move(value), deadline);
+        return true;
+    }
+
 private:
-void updateExistingNode(NodePtr node, const Value& value) 
+    size_t weightOf(NodeIndex node) const
+    {
+        return weighEntry(weigher_, pool_[node].key_, pool_[node].value_);
+    }
+
+    // 清空所有条目，节点池的内存保留下来复用
+    void clearLocked()
+    {
+        nodeMap_.clear();
+        wheel_.clear();
+        pool_.clear();
+        weightedSize_ = 0;
+        dummy_ = pool_.allocate(Key(), Value());
+        pool_[dummy_].prev_ = dummy_;
+        pool_[dummy_].next_ = dummy_;
+    }
+
+    // deadline 为 0 表示不过期。K / V 为右值时移动进结点，不再额外复制
+    template<typename K, typename V>
+    void putLocked(K&& key, V&& value, uint64_t deadline)
+    {
+        this->stats_.add(CacheEvent::Put);
+        auto it = nodeMap_.find(key);
+        NodeIndex node = it != nodeMap_.end() ? updateExistingNode(it->second, std::forward<V>(value))
+                                              : addNewNode(std::forward<K>(key), std::forward<V>(value));
+        if (node == NodePoolType::kNull) {
+            return;
+        }
+        uint32_t& timer = pool_[node].timer_;
+        if (deadline == 0) {
+            wheel_.cancel(timer);
+            timer = TimerWheel<NodeIndex>::kNone;
+        } else {
+            timer = wheel_.reschedule(timer, node, deadline);
+        }
+    }
+
+    // 推进时间轮，回收到期的条目，让它们不再和有效数据竞争容量
+    size_t expireLocked()
+    {
+        if (wheel_.empty()) {
+            return 0;
+        }
+        size_t expired = wheel_.advance(expiryNow(), [this](NodeIndex node) {
+            pool_[node].timer_ = TimerWheel<NodeIndex>::kNone;
+            removeEntry(node);
+        });
+        this->stats_.add(CacheEvent::Expiration, expired);
+        return expired;
+    }
+
+    // 值变大时同样要淘汰到总权重不超过容量；单个条目就超过容量时直接移除。
+    // 返回更新后的结点，被移除时返回 kNull
+    template<typename V>
+    NodeIndex updateExistingNode(NodeIndex node, V&& value) 
     {
-        node->setValue(value);
+        size_t oldWeight = weightOf(node);
+        pool_[node].value_ = std::forward<V>(value);
+        size_t newWeight = weightOf(node);
+        weightedSize_ = weightedSize_ - oldWeight + newWeight;
+        if (newWeight > capacity_) {
+            removeEntry(node);
+            return NodePoolType::kNull;
+        }
         moveToMostRecent(node);
+        while (weightedSize_ > capacity_) {
+            evictLeastRecent();
+        }
+        return node;
     }
 
-    void addNewNode(const Key& key, const Value& value) 
+    // key 在结点和索引中各存一份：先复制进结点，再把参数本身移动进索引
+    template<typename K, typename V>
+    NodeIndex addNewNode(K&& key, V&& value) 
     {
-        if (nodeMap_.size() >= capacity_) {
+        size_t weight = weighEntry(weigher_, key, value);
+        if (weight > capacity_) {
+            return NodePoolType::kNull;
+        }
+        while (weightedSize_ + weight > capacity_ && !nodeMap_.empty()) {
             evictLeastRecent();
         }
-        NodePtr newNode = std::make_shared<LruNodeType>(key, value);
+        NodeIndex newNode = pool_.allocate(key, std::forward<V>(value));
         insertNode(newNode);
-        nodeMap_[key] = newNode;
+        nodeMap_.emplace(std::forward<K>(key), newNode);
+        weightedSize_ += weight;
+        return newNode;
+    }
+
+    // 从链表、索引和时间轮中移除结点，槽位回到节点池的空闲链表中
+    void removeEntry(NodeIndex node)
+    {
+        weightedSize_ -= weightOf(node);
+        removeNode(node);
+        wheel_.cancel(pool_[node].timer_);
+        nodeMap_.erase(pool_[node].key_);
+        pool_.release(node);
     }
 
     // 将该节点移动到最新的位置
-    void moveToMostRecent(NodePtr node) 
+    void moveToMostRecent(NodeIndex node) 
     {
         removeNode(node);
         insertNode(node);
     }
 
-    void removeNode(NodePtr node) 
+    void removeNode(NodeIndex node) 
     {
-        node->prev_->next_ = node->next_;
-        node->next_->prev_ = node->prev_;
+        LruNodeType& n = pool_[node];
+        pool_[n.prev_].next_ = n.next_;
+        pool_[n.next_].prev_ = n.prev_;
     }
 
     // 从尾部插入结点
-    void insertNode(NodePtr node) 
+    void insertNode(NodeIndex node) 
     {
-        node->next_ = dummyTail_;
-        node->prev_ = dummyTail_->prev_;
-        dummyTail_->prev_->next_ = node;
-        dummyTail_->prev_ = node;
+        LruNodeType& n = pool_[node];
+        LruNodeType& tail = pool_[dummy_];
+        n.next_ = dummy_;
+        n.prev_ = tail.prev_;
+        pool_[tail.prev_].next_ = node;
+        tail.prev_ = node;
     }
 
     // 驱逐最近最少访问
     void evictLeastRecent() 
     {
-        NodePtr leastRecent = dummyHead_->next_;
-        removeNode(leastRecent);
-        nodeMap_.erase(leastRecent->getKey());
+        NodeIndex leastRecent = pool_[dummy_].next_;
+        if (leastRecent == dummy_) {
+            return;
+        }
+        removeEntry(leastRecent);
+        this->stats_.add(CacheEvent::Eviction);
     }
 
 private:
-    int capacity_;
-    NodeMap nodeMap_;
-    std::mutex mutex_;
-    NodePtr dummyHead_;
-    NodePtr dummyTail_;
+    size_t       capacity_;     // 权重上限，未设置 weigher 时即条目数上限
+    size_t       weightedSize_;
+    WeigherType  weigher_;
+    NodeMap      nodeMap_;
+    std::mutex   mutex_;
+    NodePoolType pool_;
+    NodeIndex    dummy_;
+    TimerWheel<NodeIndex> wheel_;   // 设置了过期时间的结点
 };
 
-// LRU优化：Lru-k版本。 通过继承的方式进行再优化
-template<typename Key, typename Value>
-class LruKCache : public LruCache<Key, Value>
+// LRU优化：Lru-k版本。 通过继承的方式进行再优化。
+// 每次 get（命中或未命中）都记入访问历史，put 只在 key 已缓存、或历史中的访问次数达到 k 时写入，只访问过一次的冷数据不会挤掉缓存。
+// 历史只保存 key 的指纹与访问次数（见 AccessHistory.h），每个历史条目 8 字节
+template<typename Key, typename Value, typename Index = StdIndex>
+class LruKCache : public LruCache<Key, Value, Index>
 {
+    using Base = LruCache<Key, Value, Index>;
+
 public:
     LruKCache(int capacity, int historyCapacity, int k) 
-        : LruCache<Key, Value>(capacity)
-        , historyList_(std::make_unique<LruCache<Key,size_t>>(historyCapacity))
-        , k_(k)
+        : Base(capacity)
+        , history_(historyCapacity > 0 ? historyCapacity : 0)
+        , k_(k > 0 ? k : 1)
     {}
 
-    Value get(Key key)
+    bool get(Key key, Value& value) override
     {
-        int historyCount = historyList_->get(key);
-        historyList_->put(key, ++historyCount);
-        return LruCache<Key, Value>::get(key);
+        uint64_t hash = LookupHash<Key>()(key);
+        {
+            std::lock_guard<std::mutex> lock(historyMutex_);
+            history_.record(hash);
+        }
+        return Base::get(key, value);
     }
 
-    void put(Key key, Value value)
+    Value get(Key key) override
     {
-        if (LruCache<Key, Value>::get(key) != "") {
-            LruCache<Key, Value>::put(key, value);
+        Value value{};
+        get(std::move(key), value);
+        return value;
+    }
+
+    // 已缓存的 key 直接更新；否则访问次数达到 k 时从历史中移出并写入缓存
+    void put(Key key, Value value) override
+    {
+        if (this->putIfPresent(key, value, 0) || !admit(key)) {
+            return;
         }
+        Base::put(std::move(key), std::move(value));
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        if (this->putIfPresent(key, value, expiryDeadline(ttl)) || !admit(key)) {
+            return;
+        }
+        Base::put(std::move(key), std::move(value), ttl);
+    }
 
-        int historyCount = historyList_->get(key);
-        if (historyCount >= k_) {
-            historyList_->remove(key);
-            LruCache<Key, Value>::put(key, value);
+    // 批量读：所有 key 在同一次加锁中记入历史
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* found) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(historyMutex_);
+            for (size_t i = 0; i < count; ++i) {
+                history_.record(LookupHash<Key>()(keys[i]));
+            }
         }
+        return Base::getMany(keys, count, values, found);
     }
 
+    void putMany(const Key* keys, const Value* values, size_t count) override
+    {
+        for (size_t i = 0; i < count; ++i) {
+            put(keys[i], values[i]);
+        }
+    }
+
+    size_t historyMemoryUsage() const { return history_.memoryUsage(); }
+
 private:
-    int                                    k_;
-    std::unique_ptr<LruCache<Key, size_t>> historyList_;
+    bool admit(const Key& key)
+    {
+        if (k_ <= 1) {
+            return true;
+        }
+        uint64_t hash = LookupHash<Key>()(key);
+        std::lock_guard<std::mutex> lock(historyMutex_);
+        return history_.admit(hash, k_);
+    }
+
+    AccessHistory history_;
+    std::mutex    historyMutex_;
+    uint32_t      k_;
 };
 
-template<typename Key, typename Value>
+// 分片 LRU。Slice 为每个分片使用的缓存实现，默认是 LruCache，
+// 读多写少的场景可以换成 ClockCache / ClockProCache（见 ClockCache.h），命中时不再串行化。
+// Router 决定 key 到分片的映射（见 ShardRouter.h）：默认的 MixRouter 先混合哈希值再映射，
+// ModuloRouter 保持旧的取模布局，ConsistentRouter 还支持用 addSlice / removeSlice 在运行时增删分片
+template<typename Key, typename Value, typename Slice = LruCache<Key, Value>, typename Router = MixRouter>
 class LruHashCache 
 {
+    using RouteGuard = RouteReadGuard<Router::kResizable>;
+
 public:
     LruHashCache(int capacity, size_t sliceNum)
-        : capacity_(capacity)
+        : LruHashCache(capacity > 0 ? capacity : 0, sliceNum, nullptr)
+    {}
+
+    // 按权重计容量，每个分片分到 ceil(maxWeight / sliceNum) 的权重
+    LruHashCache(size_t maxWeight, size_t sliceNum, Weigher<Key, Value> weigher)
+        : capacity_(maxWeight)
         , sliceNum_(sliceNum > 0 ? sliceNum : std::max<size_t>(1, std::thread::hardware_concurrency()))
+        , weigher_(std::move(weigher))
+        , router_(sliceNum_)
     {
-        size_t silceSize = std::ceil(capacity / static_cast<double>(sliceNum_));
+        size_t silceSize = std::ceil(maxWeight / static_cast<double>(sliceNum_));
         for (size_t i = 0; i < sliceNum_; i++) {
-            lruHashCache_.emplace_back(new LruCache<Key, Value>(silceSize));
+            lruHashCache_.emplace_back(new Slice(silceSize, weigher_));
         }
     }
     
     void put(Key key, Value value) 
     {
-        size_t sliceIndex = Hash(key) % sliceNum_;
-        lruHashCache_[sliceIndex]->put(key, value);
+        RouteGuard guard(routeLock_);
+        lruHashCache_[sliceOf(key)]->put(std::move(key), std::move(value));
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl)
+    {
+        RouteGuard guard(routeLock_);
+        lruHashCache_[sliceOf(key)]->put(std::move(key), std::move(value), ttl);
+    }
+
+    // 值在选择分片、加锁之前构造好
+    template<typename... Args>
+    void emplace(Key key, Args&&... args)
+    {
+        put(std::move(key), Value(std::forward<Args>(args)...));
     }
 
     bool get(Key key, Value& value) 
     {
-        size_t sliceIndex = Hash(key) % sliceNum_;
-        return lruHashCache_[sliceIndex]->get(key, value);
+        RouteGuard guard(routeLock_);
+        return lruHashCache_[sliceOf(key)]->get(key, value);
+    }
+
+    // 异构查找与不复制值的访问，转发给分片（需要 Slice 提供同名接口，见 LruCache）。
+    // 分片按 LookupHash 选择，与用 Key 本身查找时落到同一个分片
+    template<typename K, typename = typename std::enable_if<!std::is_same<K, Key>::value>::type>
+    bool get(const K& key, Value& value)
+    {
+        RouteGuard guard(routeLock_);
+        return lruHashCache_[sliceOf(key)]->get(key, value);
+    }
+
+    template<typename K, typename Fn>
+    bool visit(const K& key, Fn&& fn)
+    {
+        RouteGuard guard(routeLock_);
+        return lruHashCache_[sliceOf(key)]->visit(key, std::forward<Fn>(fn));
     }
 
     Value get(Key key) 
@@ -225,13 +714,178 @@ public:
         get(key, value);
         return value;
     }
+
+    // 批量接口：按分片分组后每个分片只加一次锁，结果写入调用方提供的缓冲区
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* found)
+    {
+        RouteGuard guard(routeLock_);
+        size_t hits = 0;
+        forEachShardGroup(keys, count,
+            [this](const Key& key) { return sliceOf(key); },
+            [&](size_t slice, const uint32_t* positions, size_t n) {
+                hits += lruHashCache_[slice]->getMany(keys, positions, n, values, found);
+            });
+        return hits;
+    }
+
+    void putMany(const Key* keys, const Value* values, size_t count)
+    {
+        RouteGuard guard(routeLock_);
+        forEachShardGroup(keys, count,
+            [this](const Key& key) { return sliceOf(key); },
+            [&](size_t slice, const uint32_t* positions, size_t n) {
+                lruHashCache_[slice]->putMany(keys, positions, n, values);
+            });
+    }
+
+    // 各分片依次加锁求和，结果不是某一时刻的精确快照
+    size_t size()
+    {
+        RouteGuard guard(routeLock_);
+        size_t total = 0;
+        for (auto& slice : lruHashCache_) {
+            total += slice->size();
+        }
+        return total;
+    }
+
+    size_t weightedSize()
+    {
+        RouteGuard guard(routeLock_);
+        size_t total = 0;
+        for (auto& slice : lruHashCache_) {
+            total += slice->weightedSize();
+        }
+        return total;
+    }
+
+    // 逐个分片回收过期条目，同一时刻只持有一个分片的锁
+    size_t purgeExpired()
+    {
+        RouteGuard guard(routeLock_);
+        size_t total = 0;
+        for (auto& slice : lruHashCache_) {
+            total += slice->purgeExpired();
+        }
+        return total;
+    }
+
+    // 每个分片一个 section，多个线程并行编码 / 解码，每个线程同一时刻只持有一个分片的锁。
+    // 分片数或路由不同时 key 到分片的映射也不同，文件头记录了路由与分片数，不一致时拒绝加载
+    bool saveSnapshot(const std::string& path)
+    {
+        RouteGuard guard(routeLock_);
+        return saveSections(path, sliceNum_,
+            [this](size_t i, SnapshotWriter& out) { lruHashCache_[i]->saveTo(out); },
+            router_.snapshotLayout());
+    }
+
+    bool loadSnapshot(const std::string& path)
+    {
+        RouteGuard guard(routeLock_);
+        return loadSections(path, sliceNum_,
+            [this](size_t i, SnapshotReader& in) { return lruHashCache_[i]->loadFrom(in); },
+            router_.snapshotLayout());
+    }
+
+    // 读穿透：未命中时由 loader(key, value) 加载并写回，同一 key 的并发未命中只调用一次 loader，
+    // loader 在分片锁之外执行。语义见 SingleFlight.h
+    template<typename Loader>
+    LoadStatus getOrLoad(const Key& key, Value& value, Loader&& loader,
+                         std::chrono::milliseconds timeout = SingleFlight<Key, Value>::kNoTimeout)
+    {
+        return flights_.getOrLoad(*this, key, value, std::forward<Loader>(loader), timeout);
+    }
+
+    uint64_t coalescedWaiters() const { return flights_.coalescedWaiters(); }
+
+    // 各分片统计之和；每个分片的计数各自读取，不是某一时刻的精确快照
+    CacheStatsSnapshot stats()
+    {
+        RouteGuard guard(routeLock_);
+        CacheStatsSnapshot total;
+        for (auto& slice : lruHashCache_) {
+            total += slice->stats();
+        }
+        return total;
+    }
+
+    void setStatsSampling(uint32_t every)
+    {
+        RouteGuard guard(routeLock_);
+        for (auto& slice : lruHashCache_) {
+            slice->setStatsSampling(every);
+        }
+    }
+
+    // 一轮分片间的容量再平衡，总容量不变，同一时刻只持有一个分片的锁。
+    // 需要周期性调用（例如由维护线程与 purgeExpired 一起调用），见 ShardRebalancer.h
+    size_t rebalance(const RebalanceOptions& options = RebalanceOptions())
+    {
+        RouteGuard guard(routeLock_);
+        return rebalancer_.run(lruHashCache_, options);
+    }
+
+    size_t sliceCount()
+    {
+        RouteGuard guard(routeLock_);
+        return sliceNum_;
+    }
+
+    // 增加一个分片（仅 Router 可伸缩时可用）：只有新路由下归属新分片的条目被迁移过去（约 1/n），
+    // 之后各分片容量重新均分为 ceil(capacity / n)。迁移期间所有读写等待，返回迁移的条目数
+    size_t addSlice()
+    {
+        static_assert(Router::kResizable, "addSlice requires a resizable router, e.g. ConsistentRouter");
+        std::lock_guard<RouteLock> lock(routeLock_);
+        size_t share = std::ceil(capacity_ / static_cast<double>(sliceNum_ + 1));
+        lruHashCache_.emplace_back(new Slice(share, weigher_));
+        router_.addSlice();
+        sliceNum_ = router_.slices();
+        size_t moved = migrateEntries<Key, Value>(lruHashCache_, 0, sliceNum_ - 1, router_,
+                                                  [this](const Key& key) { return Hash(key); });
+        // 迁出之后再缩小原有分片，留下的条目不会因为份额变小而被多淘汰
+        for (size_t i = 0; i + 1 < sliceNum_; ++i) {
+            lruHashCache_[i]->setCapacity(share);
+        }
+        return moved;
+    }
+
+    // 删除最后一个分片（至少保留一个）：先把其余分片扩大到新的份额，再把它的条目迁移到新路由下的归属分片
+    size_t removeSlice()
+    {
+        static_assert(Router::kResizable, "removeSlice requires a resizable router, e.g. ConsistentRouter");
+        std::lock_guard<RouteLock> lock(routeLock_);
+        if (sliceNum_ <= 1) {
+            return 0;
+        }
+        size_t share = std::ceil(capacity_ / static_cast<double>(sliceNum_ - 1));
+        for (size_t i = 0; i + 1 < sliceNum_; ++i) {
+            lruHashCache_[i]->setCapacity(share);
+        }
+        router_.removeSlice();
+        size_t moved = migrateEntries<Key, Value>(lruHashCache_, sliceNum_ - 1, sliceNum_, router_,
+                                                  [this](const Key& key) { return Hash(key); });
+        lruHashCache_.pop_back();
+        sliceNum_ = router_.slices();
+        return moved;
+    }
 public:
-    size_t Hash(Key key) {
-        std::hash<Key> hashFunc;  // 确保这里使用了正确的模板类型
+    template<typename K>
+    size_t Hash(const K& key) {
+        LookupHash<Key> hashFunc;  // 与 std::hash<Key> 结果相同，Key 为 std::string 时还接受 std::string_view
         return hashFunc(key);
     }
 private:
-    int                                    capacity_;
+    template<typename K>
+    size_t sliceOf(const K& key) { return router_.route(Hash(key)); }
+
+    size_t                                 capacity_;
     size_t                                 sliceNum_;
-    std::vector<std::unique_ptr<LruCache<Key, Value>>> lruHashCache_;
-};
\ No newline at end of file
+    Weigher<Key, Value>                    weigher_;    // 增加分片时构造新分片用
+    Router                                 router_;
+    RouteLock                              routeLock_;  // Router 可伸缩时保护 router_ 与分片数组
+    std::vector<std::unique_ptr<Slice>>    lruHashCache_;
+    SingleFlight<Key, Value>               flights_;
+    ShardRebalancer                        rebalancer_;
+};
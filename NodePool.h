@@ -0,0 +1,171 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// slab 节点池：节点放在按 2 倍递增的连续 slab 中，节点之间用 32 位下标互相链接，
+// 释放的槽位挂到空闲链表上复用。相比每个节点一次 make_shared，
+// 没有控制块、没有引用计数的原子操作，相邻节点在内存中也更紧凑。
+// slab 一旦分配就不会移动，所以池中对象的地址在其生命周期内保持稳定。
+template<typename T>
+class NodePool
+{
+public:
+    using Index = uint32_t;
+    static constexpr Index kNull = UINT32_MAX;
+
+    NodePool() = default;
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    ~NodePool() { clear(); }
+
+    template<typename... Args>
+    Index allocate(Args&&... args)
+    {
+        Index idx;
+        if (freeHead_ != kNull) {
+            idx = freeHead_;
+            freeHead_ = slot(idx).nextFree;
+        } else {
+            idx = end_;
+            size_t slab = slabOf(idx);
+            if (!slabs_[slab]) {
+                slabs_[slab].reset(new Slot[slabSize(slab)]);
+            }
+            ++end_;
+            if ((end_ + 63) / 64 > live_.size()) {
+                live_.push_back(0);
+            }
+        }
+        new (slot(idx).storage) T(std::forward<Args>(args)...);
+        live_[idx / 64] |= uint64_t(1) << (idx % 64);
+        ++size_;
+        return idx;
+    }
+
+    void release(Index idx)
+    {
+        (*this)[idx].~T();
+        live_[idx / 64] &= ~(uint64_t(1) << (idx % 64));
+        slot(idx).nextFree = freeHead_;
+        freeHead_ = idx;
+        --size_;
+    }
+
+    T& operator[](Index idx)
+    {
+        return *std::launder(reinterpret_cast<T*>(slot(idx).storage));
+    }
+
+    const T& operator[](Index idx) const
+    {
+        return *std::launder(reinterpret_cast<const T*>(slot(idx).storage));
+    }
+
+    // 提前把节点所在的缓存行拉进 cache，用于批量访问时隐藏访存延迟
+    void prefetch(Index idx) const
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(slot(idx).storage);
+#else
+        (void)idx;
+#endif
+    }
+
+    // 析构所有存活节点，slab 内存保留下来供后续复用
+    void clear()
+    {
+        for (size_t word = 0; word < live_.size(); ++word) {
+            uint64_t bits = live_[word];
+            while (bits) {
+                Index idx = static_cast<Index>(word * 64 + lowestBit(bits));
+                (*this)[idx].~T();
+                bits &= bits - 1;
+            }
+            live_[word] = 0;
+        }
+        freeHead_ = kNull;
+        end_ = 0;
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+
+    // 下标是否指向一个存活的节点（释放后尚未复用的槽位返回 false）
+    bool live(Index idx) const
+    {
+        return idx < end_ && ((live_[idx / 64] >> (idx % 64)) & 1) != 0;
+    }
+
+    // 池当前占用的字节数（slab 与存活位图），用于估算每个条目的内存开销
+    size_t memoryUsage() const
+    {
+        size_t bytes = live_.capacity() * sizeof(uint64_t);
+        for (size_t i = 0; i < kMaxSlabs && slabs_[i]; ++i) {
+            bytes += slabSize(i) * sizeof(Slot);
+        }
+        return bytes;
+    }
+
+private:
+    // 空闲时槽位里只存空闲链表的下一个下标，占用时存放对象本身
+    union Slot
+    {
+        Index nextFree;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    // 第 i 个 slab 容纳 kFirstSlab << i 个槽位，下标 idx 落在
+    // highestBit(idx + kFirstSlab) - kFirstSlabBits 号 slab 中
+    static constexpr size_t kFirstSlabBits = 4;
+    static constexpr size_t kFirstSlab = size_t(1) << kFirstSlabBits;
+    static constexpr size_t kMaxSlabs = 32 - kFirstSlabBits;
+
+    static size_t highestBit(uint64_t v)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(v);
+#else
+        size_t bit = 0;
+        while (v >>= 1) ++bit;
+        return bit;
+#endif
+    }
+
+    static size_t lowestBit(uint64_t v)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(v);
+#else
+        size_t bit = 0;
+        while (!(v & 1)) { v >>= 1; ++bit; }
+        return bit;
+#endif
+    }
+
+    static size_t slabOf(Index idx) { return highestBit(uint64_t(idx) + kFirstSlab) - kFirstSlabBits; }
+    static size_t slabSize(size_t slab) { return kFirstSlab << slab; }
+
+    Slot& slot(Index idx)
+    {
+        size_t slab = slabOf(idx);
+        return slabs_[slab][uint64_t(idx) + kFirstSlab - slabSize(slab)];
+    }
+
+    const Slot& slot(Index idx) const
+    {
+        size_t slab = slabOf(idx);
+        return slabs_[slab][uint64_t(idx) + kFirstSlab - slabSize(slab)];
+    }
+
+private:
+    std::unique_ptr<Slot[]> slabs_[kMaxSlabs];
+    std::vector<uint64_t>   live_;               // 每个槽位一位，标记是否存放着存活对象
+    Index                   freeHead_ = kNull;   // 空闲链表头
+    Index                   end_ = 0;            // 尚未使用过的第一个下标
+    size_t                  size_ = 0;
+};
@@ -0,0 +1,231 @@
+#pragma once
+#include "Cachepolicy.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 有损的条带化读缓冲：每个线程按线程 id 落到一个条带上，条带是固定大小的环形缓冲区。
+// 生产者（命中的读线程）用 CAS 预留槽位后写入，缓冲区已满或 CAS 失败时直接丢弃这次记录；
+// 消费者只有一个（持有独占锁的线程），按写入顺序批量取出。
+template<typename T>
+class StripedReadBuffer
+{
+public:
+    static constexpr uint32_t kStripeCapacity = 16;
+
+    enum class OfferResult { Success, Full, Failed };
+
+    StripedReadBuffer()
+    {
+        size_t want = std::max<size_t>(1, std::thread::hardware_concurrency()) * 4;
+        size_t count = 1;
+        while (count < want && count < 64) {
+            count <<= 1;
+        }
+        mask_ = count - 1;
+        for (size_t i = 0; i < count; ++i) {
+            stripes_.emplace_back(new Stripe());
+        }
+    }
+
+    OfferResult offer(const T& item)
+    {
+        Stripe& stripe = *stripes_[probe() & mask_];
+        uint32_t head = stripe.writeCounter.load(std::memory_order_relaxed);
+        uint32_t tail = stripe.readCounter.load(std::memory_order_acquire);
+        if (head - tail >= kStripeCapacity) {
+            return OfferResult::Full;
+        }
+        if (!stripe.writeCounter.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel)) {
+            return OfferResult::Failed;
+        }
+        Slot& slot = stripe.slots[head % kStripeCapacity];
+        slot.value = item;
+        slot.ready.store(true, std::memory_order_release);
+        return OfferResult::Success;
+    }
+
+    // 取出所有已发布的记录，只能由单个消费者调用
+    template<typename Fn>
+    void drain(Fn fn)
+    {
+        for (auto& stripe : stripes_) {
+            uint32_t read = stripe->readCounter.load(std::memory_order_relaxed);
+            uint32_t write = stripe->writeCounter.load(std::memory_order_acquire);
+            for (; read != write; ++read) {
+                Slot& slot = stripe->slots[read % kStripeCapacity];
+                if (!slot.ready.load(std::memory_order_acquire)) {
+                    break;
+                }
+                fn(slot.value);
+                slot.ready.store(false, std::memory_order_relaxed);
+            }
+            stripe->readCounter.store(read, std::memory_order_release);
+        }
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<bool> ready{false};
+        T value{};
+    };
+
+    // 每个条带独占缓存行，避免不同线程的计数器互相伪共享
+    struct alignas(64) Stripe
+    {
+        std::atomic<uint32_t> writeCounter{0};
+        alignas(64) std::atomic<uint32_t> readCounter{0};
+        Slot slots[kStripeCapacity];
+    };
+
+    static size_t probe()
+    {
+        static thread_local size_t hash =
+            (std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ull) >> 32;
+        return hash;
+    }
+
+private:
+    size_t                               mask_;
+    std::vector<std::unique_ptr<Stripe>> stripes_;
+};
+
+// 访问记录层：命中路径只在共享锁下查找条目并把条目的访问句柄追加到读缓冲，不碰策略自身的 mutex_，
+// 也不调整链表；访问顺序在写操作已持有独占锁时、缓冲区写满时（尽力而为）或 maintain() 时批量回放。
+// 负载过高时丢失部分访问记录是可以接受的，只会让替换顺序略微近似。
+//
+// Cache 需要提供:
+//   AccessToken                                 访问句柄类型，读缓冲中只保存它
+//   bool peek(const Key&, Value&, AccessToken&) 只读查找并给出句柄，可被多个线程并发调用
+//   void touch(const AccessToken&)              回放一次访问，调整访问顺序
+// 目前 LruCache 与 ArcCache 满足这一约定。
+template<typename Key, typename Value, typename Cache>
+class ReadBufferedCache : public CachePolicy<Key, Value>
+{
+    using Token = typename Cache::AccessToken;
+
+public:
+    template<typename... Args>
+    explicit ReadBufferedCache(Args&&... args)
+        : cache_(std::forward<Args>(args)...)
+    {}
+
+    ~ReadBufferedCache() override = default;
+
+    void put(Key key, Value value) override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        drainLocked();
+        cache_.put(std::move(key), std::move(value));
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        drainLocked();
+        cache_.put(std::move(key), std::move(value), ttl);
+    }
+
+    bool get(Key key, Value& value) override
+    {
+        typename StripedReadBuffer<Token>::OfferResult result;
+        {
+            StatsTimer timer(this->stats_, CacheStats::Op::Get);
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            timer.locked();
+            Token token{};
+            if (!cache_.peek(key, value, token)) {
+                this->stats_.addConcurrent(CacheEvent::Miss);
+                return false;
+            }
+            this->stats_.addConcurrent(CacheEvent::Hit);
+            result = readBuffer_.offer(token);
+        }
+
+        // 缓冲区已满：能立即拿到独占锁就顺手回放，拿不到就交给下一个写者
+        if (result == StripedReadBuffer<Token>::OfferResult::Full) {
+            std::unique_lock<std::shared_mutex> lock(mutex_, std::try_to_lock);
+            if (lock.owns_lock()) {
+                drainLocked();
+            }
+        }
+        return true;
+    }
+
+    Value get(Key key) override
+    {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    size_t size() override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return cache_.size();
+    }
+
+    size_t weightedSize() override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return cache_.weightedSize();
+    }
+
+    size_t purgeExpired() override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        drainLocked();
+        return cache_.purgeExpired();
+    }
+
+    // 命中与未命中由本层在读路径上统计（被回放的访问在底层缓存中也会计为命中，这里不采用），
+    // 其余事件与写操作的延迟来自底层缓存
+    CacheStatsSnapshot stats() override
+    {
+        CacheStatsSnapshot inner;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            inner = cache_.stats();
+        }
+        CacheStatsSnapshot own = this->stats_.snapshot();
+        inner.hits = own.hits;
+        inner.misses = own.misses;
+        inner.getLatency = own.getLatency;
+        inner.lockWait.merge(own.lockWait);
+        return inner;
+    }
+
+    void setStatsSampling(uint32_t every) override
+    {
+        this->stats_.setSampling(every);
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        cache_.setStatsSampling(every);
+    }
+
+    // 维护入口：把读缓冲中积压的访问全部回放到替换策略中，并回收已过期的条目
+    void maintain()
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        drainLocked();
+        cache_.purgeExpired();
+    }
+
+private:
+    void drainLocked()
+    {
+        readBuffer_.drain([this](const Token& token) { cache_.touch(token); });
+    }
+
+private:
+    Cache                    cache_;
+    StripedReadBuffer<Token> readBuffer_;
+    std::shared_mutex        mutex_;
+};
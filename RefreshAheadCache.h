@@ -0,0 +1,213 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+
+#include "Cachepolicy.h"
+#include "HashMix.h"
+#include "LruCache.h"
+#include "SingleFlight.h"
+#include "ThreadPool.h"
+#include "TimerWheel.h"
+
+// 底层缓存中实际保存的内容：值、加载（写入）时的刻度、写入时使用的 ttl（0 表示不过期），
+// 以及每次写入都不同的版本号，后台刷新据此判断条目在加载期间有没有被改写
+template<typename Value>
+struct RefreshEntry
+{
+    Value    value{};
+    uint64_t loadedAt = 0;
+    int64_t  ttlMs = 0;
+    uint64_t version = 0;
+};
+
+// 刷新参数。条目写入超过 refreshAfter 之后再被读到，就在后台重新加载，期间继续返回旧值；
+// 与 ttl 一起使用时，[refreshAfter, ttl) 就是刷新窗口：窗口内有访问的热点条目不会过期，
+// 窗口内无人访问的条目照常过期
+struct RefreshOptions
+{
+    std::chrono::milliseconds refreshAfter{0};  // 0 表示不刷新
+    std::chrono::milliseconds ttl{0};           // 不带 ttl 的 put 与刷新写回使用的过期时间，0 表示不过期
+    size_t                    threads = 2;      // 后台加载线程数
+    size_t                    maxInFlight = 64; // 同时排队或执行中的刷新上限，超出的刷新请求直接放弃
+};
+
+// 提前刷新层：读路径只在命中的条目"变旧"时登记一次后台刷新，从不等待 loader；
+// 同一 key 同时最多一个刷新在进行。loader(key, value) 返回 false 或抛出异常时保留旧值，
+// 之后的访问会再次尝试。加载期间条目被 put 改写、淘汰或过期时丢弃刷新结果，显式写入总是优先。
+// 未命中由 getOrLoad 同步加载（同一 key 的并发未命中合并，见 SingleFlight.h）。
+//
+// Cache 为实际存放条目的缓存，值类型是 RefreshEntry<Value>，需要提供
+// get(Key, V&) / put(Key, V) / put(Key, V, ttl) / purgeExpired() / size() / weightedSize()，
+// 且自身是线程安全的：各个 CachePolicy 实现与分片缓存（默认 LruHashCache）都满足。
+template<typename Key, typename Value, typename Cache = LruHashCache<Key, RefreshEntry<Value>>>
+class RefreshAheadCache : public CachePolicy<Key, Value>
+{
+public:
+    using Loader = std::function<bool(const Key&, Value&)>;
+    using Entry = RefreshEntry<Value>;
+
+    template<typename... Args>
+    RefreshAheadCache(Loader loader, RefreshOptions options, Args&&... args)
+        : loader_(std::move(loader))
+        , options_(options)
+        , cache_(std::forward<Args>(args)...)
+        , pool_(options.threads)
+    {}
+
+    ~RefreshAheadCache() override = default;
+
+    void put(Key key, Value value) override
+    {
+        store(key, std::move(value), options_.ttl.count());
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        store(key, std::move(value), std::max<int64_t>(1, ttl.count()));
+    }
+
+    bool get(Key key, Value& value) override
+    {
+        Entry entry;
+        if (!cache_.get(key, entry)) {
+            return false;
+        }
+        value = std::move(entry.value);
+        if (options_.refreshAfter.count() > 0 &&
+            expiryNow() - entry.loadedAt >= static_cast<uint64_t>(options_.refreshAfter.count())) {
+            scheduleRefresh(key, entry.ttlMs, entry.version);
+        }
+        return true;
+    }
+
+    Value get(Key key) override
+    {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 读穿透：命中时与 get 相同（必要时登记后台刷新），未命中时同步调用 loader 并写回
+    LoadStatus getOrLoad(const Key& key, Value& value,
+                         std::chrono::milliseconds timeout = SingleFlight<Key, Value>::kNoTimeout)
+    {
+        return flights_.getOrLoad(*this, key, value, loader_, timeout);
+    }
+
+    size_t purgeExpired() override { return cache_.purgeExpired(); }
+
+    size_t size() override { return cache_.size(); }
+
+    size_t weightedSize() override { return cache_.weightedSize(); }
+
+    CacheStatsSnapshot stats() override { return cache_.stats(); }
+
+    void setStatsSampling(uint32_t every) override { cache_.setStatsSampling(every); }
+
+    // 已完成的后台刷新次数
+    uint64_t refreshes() const { return refreshes_.load(std::memory_order_relaxed); }
+    // loader 返回 false 或抛出异常、保留了旧值的刷新次数
+    uint64_t refreshFailures() const { return failures_.load(std::memory_order_relaxed); }
+    // 因达到 maxInFlight 而放弃的刷新请求
+    uint64_t refreshesDropped() const { return dropped_.load(std::memory_order_relaxed); }
+    // 加载完成时条目已被改写、淘汰或过期而丢弃的刷新结果
+    uint64_t refreshesDiscarded() const { return discarded_.load(std::memory_order_relaxed); }
+    uint64_t coalescedWaiters() const { return flights_.coalescedWaiters(); }
+
+private:
+    void store(const Key& key, Value value, int64_t ttlMs)
+    {
+        std::lock_guard<std::mutex> lock(writeLockOf(key));
+        storeLocked(key, std::move(value), ttlMs);
+    }
+
+    // 调用方持有 key 所在的写入条带
+    void storeLocked(const Key& key, Value value, int64_t ttlMs)
+    {
+        Entry entry;
+        entry.value = std::move(value);
+        entry.loadedAt = expiryNow();
+        entry.ttlMs = ttlMs;
+        entry.version = nextVersion_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (ttlMs > 0) {
+            cache_.put(key, std::move(entry), std::chrono::milliseconds(ttlMs));
+        } else {
+            cache_.put(key, std::move(entry));
+        }
+    }
+
+    // 只在登记表上短暂加锁，loader 在线程池中执行
+    void scheduleRefresh(const Key& key, int64_t ttlMs, uint64_t version)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (inFlight_.count(key)) {
+                return;
+            }
+            if (inFlight_.size() >= options_.maxInFlight) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            inFlight_.insert(key);
+        }
+        pool_.submit([this, key, ttlMs, version]() { refresh(key, ttlMs, version); });
+    }
+
+    // 写回前在 key 的写入条带内确认条目仍是登记刷新时读到的那个版本；确认用的 get 会计入底层缓存的命中
+    void refresh(const Key& key, int64_t ttlMs, uint64_t version)
+    {
+        Value value{};
+        bool loaded = false;
+        try {
+            loaded = loader_(key, value);
+        } catch (...) {
+            loaded = false;
+        }
+        if (loaded) {
+            std::lock_guard<std::mutex> writeLock(writeLockOf(key));
+            Entry current;
+            if (cache_.get(key, current) && current.version == version) {
+                storeLocked(key, std::move(value), ttlMs);
+                refreshes_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                discarded_.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        inFlight_.erase(key);
+    }
+
+    std::mutex& writeLockOf(const Key& key)
+    {
+        return writeLocks_[mixHash(static_cast<uint64_t>(std::hash<Key>()(key))) & (kWriteStripes - 1)].mutex;
+    }
+
+private:
+    static constexpr size_t kWriteStripes = 16;
+
+    struct alignas(64) WriteStripe
+    {
+        std::mutex mutex;
+    };
+
+    Loader                   loader_;
+    RefreshOptions           options_;
+    Cache                    cache_;
+    SingleFlight<Key, Value> flights_;
+    std::mutex               mutex_;
+    std::unordered_set<Key>  inFlight_;     // 排队或执行中的刷新
+    std::atomic<uint64_t>    refreshes_{0};
+    std::atomic<uint64_t>    failures_{0};
+    std::atomic<uint64_t>    dropped_{0};
+    std::atomic<uint64_t>    discarded_{0};
+    std::atomic<uint64_t>    nextVersion_{0};
+    WriteStripe              writeLocks_[kWriteStripes];    // put 与刷新写回按 key 分条带互斥
+    ThreadPool               pool_;         // 最后构造、最先析构：工作线程退出后才销毁它们用到的成员
+};
@@ -0,0 +1,486 @@
+#pragma once
+#include "Cachepolicy.h"
+#include "CacheWeigher.h"
+#include "FlatHashMap.h"
+#include "NodePool.h"
+#include "TimerWheel.h"
+#include "ArcCache/ArcGhostIndex.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+// S3-FIFO：小 FIFO（约 10% 容量）接纳新条目，主 FIFO 存放被再次访问过的条目，幽灵 FIFO 只记录从小 FIFO 淘汰的 key 指纹。
+// 与 CLOCK 一样，命中时只在共享锁下把条目的访问计数（0..3）原子地加一，计数已封顶时连写都不写，
+// 不移动任何结点；出队、入队、降级都在写入路径（独占锁）上完成。命中之间只共享读写锁的读者计数，不互相阻塞。
+// 过期的条目在共享锁下只当作未命中，由下一次写入或 purgeExpired 在独占锁下回收。
+
+// 条目所在的队列；Removed 为已从索引中删除、还留在队列里等出队时回收的结点
+enum class S3FifoSegment : uint8_t { Small, Main, Removed };
+
+template<typename Key, typename Value, typename Index> class S3FifoCache;
+
+template<typename Key, typename Value>
+class S3FifoNode
+{
+private:
+    Key key_;
+    Value value_;
+    std::atomic<uint8_t> freq_;     // 入队后的访问次数，封顶为 3
+    S3FifoSegment segment_;
+    uint32_t timer_;                // 过期定时器，没有过期时间时为 kNone
+
+public:
+    S3FifoNode(Key key, Value value)
+        : key_(std::move(key))
+        , value_(std::move(value))
+        , freq_(0)
+        , segment_(S3FifoSegment::Small)
+        , timer_(TimerWheel<uint32_t>::kNone)
+    {}
+
+    template<typename K, typename V, typename I> friend class S3FifoCache;
+};
+
+// 节点池下标组成的 FIFO 环形队列，容量按 2 的幂倍增。不加锁，由所属的缓存在独占锁内调用
+class NodeRing
+{
+public:
+    void push(uint32_t node)
+    {
+        if (size_ == ring_.size()) {
+            grow();
+        }
+        ring_[(head_ + size_) & mask_] = node;
+        ++size_;
+    }
+
+    uint32_t pop()
+    {
+        uint32_t node = ring_[head_];
+        head_ = (head_ + 1) & mask_;
+        --size_;
+        return node;
+    }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    void clear()
+    {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    // 保持先后顺序删除 pred(node) 为 true 的元素
+    template<typename Pred>
+    void removeIf(Pred pred)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < size_; ++i) {
+            uint32_t node = ring_[(head_ + i) & mask_];
+            if (!pred(node)) {
+                ring_[(head_ + kept) & mask_] = node;
+                ++kept;
+            }
+        }
+        size_ = kept;
+    }
+
+private:
+    // 按出队顺序拷贝到更大的数组中，起点回到 0
+    void grow()
+    {
+        std::vector<uint32_t> ring(std::max<size_t>(16, 2 * ring_.size()));
+        for (size_t i = 0; i < size_; ++i) {
+            ring[i] = ring_[(head_ + i) & mask_];
+        }
+        ring_.swap(ring);
+        mask_ = ring_.size() - 1;
+        head_ = 0;
+    }
+
+    std::vector<uint32_t> ring_;
+    size_t                mask_ = 0;
+    size_t                head_ = 0;
+    size_t                size_ = 0;
+};
+
+template<typename Key, typename Value, typename Index = StdIndex>
+class S3FifoCache : public CachePolicy<Key, Value>
+{
+public:
+    using NodeType = S3FifoNode<Key, Value>;
+    using NodePoolType = NodePool<NodeType>;
+    using NodeIndex = typename NodePoolType::Index;
+    using NodeMap = typename Index::template Map<Key, NodeIndex>;
+    using WeigherType = Weigher<Key, Value>;
+
+    explicit S3FifoCache(int capacity)
+        : S3FifoCache(capacity > 0 ? capacity : 0, nullptr)
+    {}
+
+    // 按权重计容量时小 FIFO 的份额同样按权重计。幽灵 FIFO 的上限按条目数计：未设置 weigher 时为 capacity，
+    // 否则随常驻条目数调整；指纹按需增长
+    S3FifoCache(size_t maxWeight, WeigherType weigher)
+        : capacity_(maxWeight)
+        , smallTarget_(std::max<size_t>(1, maxWeight / 10))
+        , weigher_(std::move(weigher))
+        , ghosts_(weigher_ ? 0 : maxWeight)
+    {}
+
+    ~S3FifoCache() override = default;
+
+    void put(Key key, Value value) override
+    {
+        if (capacity_ == 0) {
+            return;
+        }
+
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        expireLocked();
+        putLocked(std::move(key), std::move(value), 0);
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        if (capacity_ == 0) {
+            return;
+        }
+
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        expireLocked();
+        putLocked(std::move(key), std::move(value), expiryDeadline(ttl));
+    }
+
+    bool get(Key key, Value& value) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Get);
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        bool hit = getLocked(key, value);
+        this->stats_.addConcurrent(hit ? CacheEvent::Hit : CacheEvent::Miss);
+        return hit;
+    }
+
+    Value get(Key key) override
+    {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* found) override
+    {
+        return getMany(keys, nullptr, count, values, found);
+    }
+
+    void putMany(const Key* keys, const Value* values, size_t count) override
+    {
+        putMany(keys, nullptr, count, values);
+    }
+
+    // 只处理 positions 指定的下标（为空时为 0..count-1），整批只加一次锁
+    size_t getMany(const Key* keys, const uint32_t* positions, size_t count, Value* values, bool* found)
+    {
+        size_t hits = 0;
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (size_t i = 0; i < count; ++i) {
+            size_t pos = positions ? positions[i] : i;
+            found[pos] = getLocked(keys[pos], values[pos]);
+            hits += found[pos] ? 1 : 0;
+        }
+        this->stats_.addConcurrent(CacheEvent::Hit, hits);
+        this->stats_.addConcurrent(CacheEvent::Miss, count - hits);
+        return hits;
+    }
+
+    void putMany(const Key* keys, const uint32_t* positions, size_t count, const Value* values)
+    {
+        if (capacity_ == 0) {
+            return;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        expireLocked();
+        for (size_t i = 0; i < count; ++i) {
+            size_t pos = positions ? positions[i] : i;
+            putLocked(keys[pos], values[pos], 0);
+        }
+    }
+
+    size_t purgeExpired() override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        return expireLocked();
+    }
+
+    size_t size() override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return nodeMap_.size();
+    }
+
+    size_t weightedSize() override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return smallWeight_ + mainWeight_;
+    }
+
+    // 主 FIFO 中的条目数，其余常驻条目在小 FIFO 中
+    size_t mainSize()
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return mainCount_;
+    }
+
+    // 幽灵 FIFO 中的指纹数
+    size_t ghostSize()
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return ghosts_.size();
+    }
+
+private:
+    static constexpr uint8_t kMaxFreq = 3;
+
+    size_t weightOf(const NodeType& n) const { return weighEntry(weigher_, n.key_, n.value_); }
+
+    bool getLocked(const Key& key, Value& value)
+    {
+        auto it = Index::find(nodeMap_, key);
+        if (it == nodeMap_.end()) {
+            return false;
+        }
+        NodeType& n = pool_[it->second];
+        if (wheel_.expired(n.timer_)) {
+            return false;
+        }
+        touch(n);
+        value = n.value_;
+        return true;
+    }
+
+    // 热点条目的计数很快封顶，之后的命中只读不写，不会让缓存行在线程之间来回失效
+    static void touch(NodeType& n)
+    {
+        uint8_t freq = n.freq_.load(std::memory_order_relaxed);
+        if (freq < kMaxFreq) {
+            n.freq_.store(freq + 1, std::memory_order_relaxed);
+        }
+    }
+
+    // deadline 为 0 表示不过期。新 key 在幽灵 FIFO 中时直接进入主 FIFO，否则进入小 FIFO
+    template<typename K, typename V>
+    void putLocked(K&& key, V&& value, uint64_t deadline)
+    {
+        this->stats_.add(CacheEvent::Put);
+        auto it = Index::find(nodeMap_, key);
+        if (it != nodeMap_.end()) {
+            NodeIndex node = it->second;
+            NodeType& n = pool_[node];
+            size_t oldWeight = weightOf(n);
+            n.value_ = std::forward<V>(value);
+            size_t weight = weightOf(n);
+            segmentWeight(n.segment_) += weight - oldWeight;
+            setExpiry(node, deadline);
+            if (weight > capacity_) {
+                removeEntry(node);
+                return;
+            }
+            touch(n);
+            while (smallWeight_ + mainWeight_ > capacity_ && evictOne()) {
+            }
+            return;
+        }
+
+        size_t weight = weighEntry(weigher_, key, value);
+        if (weight > capacity_) {
+            return;
+        }
+        while (smallWeight_ + mainWeight_ + weight > capacity_ && evictOne()) {
+        }
+        bool ghostHit = ghosts_.remove(ghostFingerprint(key));
+        NodeIndex node = pool_.allocate(key, std::forward<V>(value));
+        nodeMap_.emplace(std::forward<K>(key), node);
+        if (ghostHit) {
+            this->stats_.add(CacheEvent::GhostHit);
+            pushMain(node, weight);
+        } else {
+            pool_[node].segment_ = S3FifoSegment::Small;
+            small_.push(node);
+            smallWeight_ += weight;
+            ++smallCount_;
+        }
+        setExpiry(node, deadline);
+    }
+
+    // 淘汰一个常驻条目，没有常驻条目时返回 false。小 FIFO 超过份额（或主 FIFO 为空）时从小 FIFO 出队，
+    // 被访问过的条目转入主 FIFO；否则从主 FIFO 出队，被访问过的条目计数减一后重新入队
+    bool evictOne()
+    {
+        while (smallCount_ + mainCount_ > 0) {
+            bool fromSmall = smallCount_ > 0 && (smallWeight_ >= smallTarget_ || mainCount_ == 0);
+            if (fromSmall ? evictSmall() : evictMain()) {
+                this->stats_.add(CacheEvent::Eviction);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool evictSmall()
+    {
+        NodeIndex node = small_.pop();
+        NodeType& n = pool_[node];
+        if (n.segment_ == S3FifoSegment::Removed) {
+            releaseRemoved(node);
+            return false;
+        }
+        size_t weight = weightOf(n);
+        smallWeight_ -= weight;
+        --smallCount_;
+        if (n.freq_.load(std::memory_order_relaxed) > 0) {
+            n.freq_.store(0, std::memory_order_relaxed);
+            pushMain(node, weight);
+            return false;
+        }
+        if (weigher_) {
+            ghosts_.setCapacity(smallCount_ + mainCount_ + 1);   // 按权重计容量时以常驻条目数为上限
+        }
+        ghosts_.add(ghostFingerprint(n.key_));
+        n.segment_ = S3FifoSegment::Removed;   // 已不在任何队列中，下面直接释放
+        dropEntry(node);
+        pool_.release(node);
+        return true;
+    }
+
+    bool evictMain()
+    {
+        NodeIndex node = main_.pop();
+        NodeType& n = pool_[node];
+        if (n.segment_ == S3FifoSegment::Removed) {
+            releaseRemoved(node);
+            return false;
+        }
+        uint8_t freq = n.freq_.load(std::memory_order_relaxed);
+        if (freq > 0) {
+            n.freq_.store(freq - 1, std::memory_order_relaxed);
+            main_.push(node);
+            return false;
+        }
+        mainWeight_ -= weightOf(n);
+        --mainCount_;
+        n.segment_ = S3FifoSegment::Removed;
+        dropEntry(node);
+        pool_.release(node);
+        return true;
+    }
+
+    void pushMain(NodeIndex node, size_t weight)
+    {
+        pool_[node].segment_ = S3FifoSegment::Main;
+        main_.push(node);
+        mainWeight_ += weight;
+        ++mainCount_;
+    }
+
+    size_t& segmentWeight(S3FifoSegment segment)
+    {
+        return segment == S3FifoSegment::Small ? smallWeight_ : mainWeight_;
+    }
+
+    void setExpiry(NodeIndex node, uint64_t deadline)
+    {
+        uint32_t& timer = pool_[node].timer_;
+        if (deadline == 0) {
+            wheel_.cancel(timer);
+            timer = TimerWheel<uint32_t>::kNone;
+        } else {
+            timer = wheel_.reschedule(timer, node, deadline);
+        }
+    }
+
+    size_t expireLocked()
+    {
+        if (wheel_.empty()) {
+            return 0;
+        }
+        size_t expired = wheel_.advance(expiryNow(), [this](NodeIndex node) {
+            pool_[node].timer_ = TimerWheel<uint32_t>::kNone;
+            removeEntry(node);
+        });
+        this->stats_.add(CacheEvent::Expiration, expired);
+        return expired;
+    }
+
+    // 从索引与时间轮中删除，值立即释放；结点留在队列里标记为 Removed，出队时再回收槽位。
+    // 被标记的结点多于常驻条目时整理一次两个队列，队列长度始终与常驻条目数同阶
+    void removeEntry(NodeIndex node)
+    {
+        NodeType& n = pool_[node];
+        if (n.segment_ == S3FifoSegment::Small) {
+            smallWeight_ -= weightOf(n);
+            --smallCount_;
+        } else {
+            mainWeight_ -= weightOf(n);
+            --mainCount_;
+        }
+        n.segment_ = S3FifoSegment::Removed;
+        dropEntry(node);
+        releaseValue(n.value_);   // 结点留在队列里等出队回收，值先释放
+        if (++removedCount_ > nodeMap_.size() + 64) {
+            compactQueues();
+        }
+    }
+
+    void dropEntry(NodeIndex node)
+    {
+        NodeType& n = pool_[node];
+        wheel_.cancel(n.timer_);
+        n.timer_ = TimerWheel<uint32_t>::kNone;
+        nodeMap_.erase(n.key_);
+    }
+
+    void releaseRemoved(NodeIndex node)
+    {
+        pool_.release(node);
+        --removedCount_;
+    }
+
+    void compactQueues()
+    {
+        auto removed = [this](NodeIndex node) {
+            if (pool_[node].segment_ != S3FifoSegment::Removed) {
+                return false;
+            }
+            releaseRemoved(node);
+            return true;
+        };
+        small_.removeIf(removed);
+        main_.removeIf(removed);
+    }
+
+private:
+    size_t               capacity_;         // 权重上限，未设置 weigher 时即条目数上限
+    size_t               smallTarget_;      // 小 FIFO 的份额
+    size_t               smallWeight_ = 0;
+    size_t               mainWeight_ = 0;
+    size_t               smallCount_ = 0;   // 两个队列中的常驻条目数，不含 Removed 结点
+    size_t               mainCount_ = 0;
+    size_t               removedCount_ = 0;
+    WeigherType          weigher_;
+    NodeMap              nodeMap_;
+    NodePoolType         pool_;
+    NodeRing             small_;
+    NodeRing             main_;
+    ArcGhostIndex        ghosts_;           // 从小 FIFO 淘汰的 key 指纹，按进入顺序老化
+    TimerWheel<uint32_t> wheel_;            // 设置了过期时间的条目
+    std::shared_mutex    mutex_;
+};
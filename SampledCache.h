@@ -0,0 +1,435 @@
+#pragma once
+#include "Cachepolicy.h"
+#include "CacheWeigher.h"
+#include "FlatHashMap.h"
+#include "TimerWheel.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 采样淘汰的近似 LRU / LFU（与 Redis 的 approximated LRU / LFU 相同的思路）：
+// 条目只存放在一个紧凑的数组里，索引记录 key 到下标的映射，没有链表，也就没有 prev_/next_。
+// 每个条目只带一个 32 位的元数据：LRU 模式是最近一次访问时的逻辑时钟，
+// LFU 模式是对数计数器（低 8 位）加上次衰减的周期号（高 24 位）。
+// 命中时在共享锁下读出时钟、写回元数据，不调整任何结构；需要淘汰时随机采样 samples 个条目，
+// 连同淘汰池里上一次留下的候选一起比较，淘汰其中最"冷"的一个。
+// 逻辑时钟在每次写入时前进一格，同一段写入之间的命中在 LRU 模式下不分先后。
+// 过期的条目在共享锁下只当作未命中，由下一次写入或 purgeExpired 在独占锁下回收。
+
+enum class SampledPolicy { Lru, Lfu };
+
+template<typename Key, typename Value, SampledPolicy Policy, typename Index> class SampledCache;
+
+template<typename Key, typename Value>
+class SampledSlot
+{
+private:
+    Key key_;
+    Value value_;
+    std::atomic<uint32_t> meta_;
+    uint32_t timer_;    // 过期定时器，没有过期时间时为 kNone
+
+public:
+    SampledSlot() : key_(), value_(), meta_(0), timer_(TimerWheel<uint32_t>::kNone) {}
+
+    template<typename K, typename V, SampledPolicy P, typename I> friend class SampledCache;
+};
+
+template<typename Key, typename Value, SampledPolicy Policy = SampledPolicy::Lru, typename Index = StdIndex>
+class SampledCache : public CachePolicy<Key, Value>
+{
+public:
+    using SlotType = SampledSlot<Key, Value>;
+    using SlotMap = typename Index::template Map<Key, uint32_t>;
+    using WeigherType = Weigher<Key, Value>;
+
+    static constexpr size_t kDefaultSamples = 10;    // 每次淘汰随机采样的条目数
+    static constexpr size_t kPoolSize = 16;         // 淘汰池保留的候选数
+
+    explicit SampledCache(int capacity, size_t samples = kDefaultSamples)
+        : SampledCache(capacity > 0 ? capacity : 0, nullptr, samples)
+    {}
+
+    // 按权重计容量：所有条目的 weigher(key, value) 之和不超过 maxWeight
+    SampledCache(size_t maxWeight, WeigherType weigher, size_t samples = kDefaultSamples)
+        : capacity_(maxWeight)
+        , weightedSize_(0)
+        , samples_(std::max<size_t>(1, samples))
+        , writesSinceDecay_(0)
+        , weigher_(std::move(weigher))
+        , clock_(0)
+        , period_(0)
+        , rng_(0x9E3779B97F4A7C15ull)
+    {
+        pool_.reserve(kPoolSize + samples_);
+    }
+
+    ~SampledCache() override = default;
+
+    void put(Key key, Value value) override
+    {
+        if (capacity_ == 0) {
+            return;
+        }
+
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        expireLocked();
+        putLocked(std::move(key), std::move(value), 0);
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        if (capacity_ == 0) {
+            return;
+        }
+
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        expireLocked();
+        putLocked(std::move(key), std::move(value), expiryDeadline(ttl));
+    }
+
+    bool get(Key key, Value& value) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Get);
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        timer.locked();
+        bool hit = getLocked(key, value);
+        this->stats_.addConcurrent(hit ? CacheEvent::Hit : CacheEvent::Miss);
+        return hit;
+    }
+
+    Value get(Key key) override
+    {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* found) override
+    {
+        size_t hits = 0;
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (size_t i = 0; i < count; ++i) {
+            found[i] = getLocked(keys[i], values[i]);
+            hits += found[i] ? 1 : 0;
+        }
+        this->stats_.addConcurrent(CacheEvent::Hit, hits);
+        this->stats_.addConcurrent(CacheEvent::Miss, count - hits);
+        return hits;
+    }
+
+    void putMany(const Key* keys, const Value* values, size_t count) override
+    {
+        if (capacity_ == 0) {
+            return;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        expireLocked();
+        for (size_t i = 0; i < count; ++i) {
+            putLocked(keys[i], values[i], 0);
+        }
+    }
+
+    size_t purgeExpired() override
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        return expireLocked();
+    }
+
+    size_t size() override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return slots_.size();
+    }
+
+    size_t weightedSize() override
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return weightedSize_;
+    }
+
+private:
+    static constexpr uint32_t kLfuInitCounter = 5;  // 新条目的初始计数，避免刚写入就被淘汰
+    static constexpr uint32_t kLfuLogFactor = 10;   // 越大计数器增长越慢，255 大约对应百万次访问
+    static constexpr uint32_t kPeriodMask = 0xFFFFFF;
+    static constexpr size_t   kLfuDecayFactor = 8;  // 每写入 8 倍条目数次，计数器衰减 1
+
+    // 淘汰候选：slot 可能因为其他条目被移除而失效，使用前按 key 校验
+    struct Candidate
+    {
+        Key      key;
+        uint32_t slot;
+        uint32_t score;
+    };
+
+    size_t weightOf(const SlotType& slot) const { return weighEntry(weigher_, slot.key_, slot.value_); }
+
+    uint32_t period() const { return period_.load(std::memory_order_relaxed); }
+
+    // 按距上次衰减经过的周期数递减计数器
+    uint32_t decayedCounter(uint32_t meta) const
+    {
+        uint32_t elapsed = (period() - (meta >> 8)) & kPeriodMask;
+        uint32_t counter = meta & 0xFF;
+        return counter > elapsed ? counter - elapsed : 0;
+    }
+
+    // 对数计数器：计数越大，再加一的概率越小。读路径上调用，随机数取线程局部状态
+    static uint32_t logIncrement(uint32_t counter)
+    {
+        if (counter >= 255) {
+            return 255;
+        }
+        static thread_local uint64_t state =
+            std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        uint32_t base = counter > kLfuInitCounter ? counter - kLfuInitCounter : 0;
+        // 以 1 / (base * kLfuLogFactor + 1) 的概率加一
+        uint64_t threshold = (uint64_t(1) << 32) / (uint64_t(base) * kLfuLogFactor + 1);
+        return (state >> 32) < threshold ? counter + 1 : counter;
+    }
+
+    // 记录一次访问。只写元数据，共享锁下可以并发调用；并发的两次更新可能丢掉其中一次
+    void touch(SlotType& slot) const
+    {
+        uint32_t meta = slot.meta_.load(std::memory_order_relaxed);
+        uint32_t next;
+        if (Policy == SampledPolicy::Lru) {
+            next = static_cast<uint32_t>(clock_.load(std::memory_order_relaxed));
+        } else {
+            next = (period() << 8) | logIncrement(decayedCounter(meta));
+        }
+        if (next != meta) {
+            slot.meta_.store(next, std::memory_order_relaxed);
+        }
+    }
+
+    // 越大越应该被淘汰：LRU 为空闲的时钟格数，LFU 为 255 减去衰减后的计数
+    uint32_t score(const SlotType& slot) const
+    {
+        uint32_t meta = slot.meta_.load(std::memory_order_relaxed);
+        if (Policy == SampledPolicy::Lru) {
+            return static_cast<uint32_t>(clock_.load(std::memory_order_relaxed)) - meta;
+        }
+        return 255 - decayedCounter(meta);
+    }
+
+    void initMeta(SlotType& slot)
+    {
+        if (Policy == SampledPolicy::Lru) {
+            slot.meta_.store(static_cast<uint32_t>(clock_.load(std::memory_order_relaxed)),
+                             std::memory_order_relaxed);
+        } else {
+            slot.meta_.store((period() << 8) | kLfuInitCounter, std::memory_order_relaxed);
+        }
+    }
+
+    bool getLocked(const Key& key, Value& value)
+    {
+        auto it = slotMap_.find(key);
+        if (it == slotMap_.end()) {
+            return false;
+        }
+        SlotType& slot = slots_[it->second];
+        if (wheel_.expired(slot.timer_)) {
+            return false;
+        }
+        touch(slot);
+        value = slot.value_;
+        return true;
+    }
+
+    // deadline 为 0 表示不过期
+    template<typename K, typename V>
+    void putLocked(K&& key, V&& value, uint64_t deadline)
+    {
+        this->stats_.add(CacheEvent::Put);
+        // 独占锁下只有本线程写时钟，读路径只读
+        clock_.store(clock_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        // 衰减周期按当前条目数而不是权重上限计：按字节计容量时后者会大到计数器永远不衰减
+        if (++writesSinceDecay_ >= kLfuDecayFactor * std::max<size_t>(1, slots_.size())) {
+            writesSinceDecay_ = 0;
+            period_.store((period() + 1) & kPeriodMask, std::memory_order_relaxed);
+        }
+
+        auto it = slotMap_.find(key);
+        if (it != slotMap_.end()) {
+            uint32_t idx = it->second;
+            SlotType& slot = slots_[idx];
+            weightedSize_ -= weightOf(slot);
+            slot.value_ = std::forward<V>(value);
+            size_t weight = weightOf(slot);
+            weightedSize_ += weight;
+            if (weight > capacity_) {
+                release(idx);
+                return;
+            }
+            touch(slot);
+            setExpiry(idx, deadline);
+            // 刚更新的条目自身也可能被采样到，淘汰后按 key 重新定位
+            while (weightedSize_ > capacity_ && evictOne()) {
+            }
+            return;
+        }
+
+        size_t weight = weighEntry(weigher_, key, value);
+        if (weight > capacity_) {
+            return;
+        }
+        while (weightedSize_ + weight > capacity_ && evictOne()) {
+        }
+
+        uint32_t idx = static_cast<uint32_t>(slots_.size());
+        slots_.emplace_back();
+        SlotType& slot = slots_[idx];
+        slot.key_ = key;
+        slot.value_ = std::forward<V>(value);
+        initMeta(slot);
+        slotMap_.emplace(std::forward<K>(key), idx);
+        weightedSize_ += weight;
+        setExpiry(idx, deadline);
+    }
+
+    void setExpiry(uint32_t idx, uint64_t deadline)
+    {
+        uint32_t& timer = slots_[idx].timer_;
+        if (deadline == 0) {
+            wheel_.cancel(timer);
+            timer = TimerWheel<uint32_t>::kNone;
+        } else {
+            timer = wheel_.reschedule(timer, idx, deadline);
+        }
+    }
+
+    size_t expireLocked()
+    {
+        if (wheel_.empty()) {
+            return 0;
+        }
+        size_t expired = wheel_.advance(expiryNow(), [this](uint32_t idx) {
+            slots_[idx].timer_ = TimerWheel<uint32_t>::kNone;
+            release(idx);
+        });
+        this->stats_.add(CacheEvent::Expiration, expired);
+        return expired;
+    }
+
+    // 把最后一个条目搬到 idx 填补空位，数组始终保持紧凑，采样时不会落到空槽上。
+    // 定时器记录的是下标，被搬动的条目要按新下标重新登记
+    void release(uint32_t idx)
+    {
+        SlotType& slot = slots_[idx];
+        weightedSize_ -= weightOf(slot);
+        wheel_.cancel(slot.timer_);
+        slot.timer_ = TimerWheel<uint32_t>::kNone;
+        slotMap_.erase(slot.key_);
+
+        uint32_t last = static_cast<uint32_t>(slots_.size() - 1);
+        if (idx != last) {
+            SlotType& moved = slots_[last];
+            slot.key_ = std::move(moved.key_);
+            slot.value_ = std::move(moved.value_);
+            slot.meta_.store(moved.meta_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            if (moved.timer_ != TimerWheel<uint32_t>::kNone) {
+                uint64_t deadline = wheel_.deadline(moved.timer_);
+                wheel_.cancel(moved.timer_);
+                slot.timer_ = wheel_.schedule(idx, deadline);
+            }
+            slotMap_.find(slot.key_)->second = idx;
+        }
+        slots_.pop_back();
+    }
+
+    uint32_t randomSlot()
+    {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 7;
+        rng_ ^= rng_ << 17;
+        return static_cast<uint32_t>(((rng_ >> 32) * slots_.size()) >> 32);
+    }
+
+    // 先按 key 校验淘汰池里的候选并重新计算分数（期间被访问过的候选分数会下降），
+    // 再随机采样 samples_ 个条目放进池中，池满时替换分数最低的；最后淘汰分数最高的候选
+    bool evictOne()
+    {
+        if (slots_.empty()) {
+            return false;
+        }
+        for (size_t i = 0; i < pool_.size(); ) {
+            Candidate& c = pool_[i];
+            if (c.slot >= slots_.size() || !(slots_[c.slot].key_ == c.key)) {
+                auto it = slotMap_.find(c.key);
+                if (it == slotMap_.end()) {
+                    pool_[i] = std::move(pool_.back());
+                    pool_.pop_back();
+                    continue;
+                }
+                c.slot = it->second;
+            }
+            c.score = score(slots_[c.slot]);
+            ++i;
+        }
+
+        for (size_t n = 0; n < samples_; ++n) {
+            uint32_t idx = randomSlot();
+            bool pooled = std::any_of(pool_.begin(), pool_.end(),
+                                      [idx](const Candidate& c) { return c.slot == idx; });
+            if (pooled) {
+                continue;
+            }
+            uint32_t s = score(slots_[idx]);
+            if (pool_.size() < kPoolSize) {
+                pool_.push_back(Candidate{slots_[idx].key_, idx, s});
+                continue;
+            }
+            auto coldest = std::min_element(pool_.begin(), pool_.end(),
+                [](const Candidate& a, const Candidate& b) { return a.score < b.score; });
+            if (s > coldest->score) {
+                *coldest = Candidate{slots_[idx].key_, idx, s};
+            }
+        }
+
+        auto victim = std::max_element(pool_.begin(), pool_.end(),
+            [](const Candidate& a, const Candidate& b) { return a.score < b.score; });
+        uint32_t idx = victim->slot;
+        *victim = std::move(pool_.back());
+        pool_.pop_back();
+        release(idx);
+        this->stats_.add(CacheEvent::Eviction);
+        return true;
+    }
+
+private:
+    size_t                  capacity_;      // 权重上限，未设置 weigher 时即条目数上限
+    size_t                  weightedSize_;
+    size_t                  samples_;
+    size_t                  writesSinceDecay_;  // 距上次衰减的写入次数，只在独占锁下使用
+    WeigherType             weigher_;
+    std::atomic<uint64_t>   clock_;         // 逻辑时钟，每次写入前进一格
+    std::atomic<uint32_t>   period_;        // LFU 计数器的衰减周期号，独占锁下递增
+    uint64_t                rng_;           // 采样用的随机数状态，只在独占锁下使用
+    std::deque<SlotType>    slots_;         // 紧凑存放的条目，deque 扩容时已有条目地址不变
+    SlotMap                 slotMap_;
+    std::vector<Candidate>  pool_;          // 淘汰池
+    TimerWheel<uint32_t>    wheel_;         // 设置了过期时间的条目
+    std::shared_mutex       mutex_;
+};
+
+template<typename Key, typename Value, typename Index = StdIndex>
+using SampledLruCache = SampledCache<Key, Value, SampledPolicy::Lru, Index>;
+
+template<typename Key, typename Value, typename Index = StdIndex>
+using SampledLfuCache = SampledCache<Key, Value, SampledPolicy::Lfu, Index>;
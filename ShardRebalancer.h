@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+// 再平衡参数
+struct RebalanceOptions
+{
+    double maxStep = 0.05;      // 每一轮一个分片最多让出自身容量的这个比例
+    double minShare = 0.25;     // 分片容量不低于平均份额的这个比例
+    double threshold = 1.5;     // 两个分片的压力相差超过这个倍数才转移容量
+};
+
+// 分片之间的容量再平衡：总容量固定，按各分片的淘汰压力（上一轮以来的淘汰数 / 当前容量，
+// 即单位容量的周转速度）把容量从压力最低的分片移给压力最高的分片。
+// 键分布倾斜时，热点分片一直在淘汰而冷分片半空，周转快的分片分到更多容量后整体命中率更接近不分片的缓存。
+//
+// 每次 run 只做一轮、每个分片最多转移 maxStep 的容量，由调用方周期性地调用（例如与 purgeExpired 一起），
+// 容量逐步收敛。淘汰数来自各分片的 stats()，定义了 CACHE_DISABLE_STATS 时不做任何调整。
+// 读统计、读容量和 setCapacity 都是对单个分片的独立调用，任何时刻最多持有一个分片的锁；
+// 先缩小让出方再扩大接收方，总容量在调整过程中也不会超出。
+class ShardRebalancer
+{
+public:
+    // shards 为分片指针的序列，分片需提供 stats() / capacity() / setCapacity(size_t)。返回本轮转移的容量
+    template<typename Shards>
+    size_t run(Shards& shards, const RebalanceOptions& options = RebalanceOptions())
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t n = shards.size();
+        std::vector<size_t> capacity(n);
+        std::vector<double> pressure(n);
+        bool first = lastEvictions_.size() != n;
+        lastEvictions_.resize(n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            capacity[i] = shards[i]->capacity();
+            uint64_t evictions = shards[i]->stats().evictions;
+            pressure[i] = static_cast<double>(evictions - lastEvictions_[i]) / std::max<size_t>(1, capacity[i]);
+            lastEvictions_[i] = evictions;
+        }
+        if (first || n < 2) {
+            return 0;   // 第一轮只记录基线
+        }
+
+        size_t total = std::accumulate(capacity.begin(), capacity.end(), size_t(0));
+        size_t floor = std::max<size_t>(1, static_cast<size_t>(total / n * options.minShare));
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return pressure[a] < pressure[b]; });
+
+        // 压力最低的与最高的配对，依次向中间收拢；配对越靠中间差距越小，不满足阈值即可停止
+        size_t moved = 0;
+        for (size_t k = 0; k < n / 2; ++k) {
+            size_t donor = order[k];
+            size_t receiver = order[n - 1 - k];
+            if (pressure[receiver] <= 0 || pressure[receiver] < pressure[donor] * options.threshold) {
+                break;
+            }
+            if (capacity[donor] <= floor) {
+                continue;
+            }
+            size_t step = std::max<size_t>(1, static_cast<size_t>(capacity[donor] * options.maxStep));
+            step = std::min(step, capacity[donor] - floor);
+            shards[donor]->setCapacity(capacity[donor] - step);
+            // 缩小引起的淘汰不计入下一轮的压力
+            lastEvictions_[donor] = shards[donor]->stats().evictions;
+            shards[receiver]->setCapacity(capacity[receiver] + step);
+            moved += step;
+        }
+        return moved;
+    }
+
+private:
+    std::mutex            mutex_;           // 同一时刻只进行一轮
+    std::vector<uint64_t> lastEvictions_;   // 上一轮读到的各分片累计淘汰数
+};
@@ -0,0 +1,229 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "HashMix.h"
+#include "StripedSharedMutex.h"
+
+// 分片缓存的路由：把 key 的哈希值（LookupHash<Key>，对整数即 key 本身）映射到分片下标。
+// 路由提供 slices() 与 route(hash)，kResizable 为 true 的路由还支持运行时增删分片。
+// snapshotLayout() 为路由种类与分片数，写进分片快照的文件头，路由不同的快照拒绝加载（见 CacheSnapshot.h）
+
+// 路由种类的编号，写进快照后不能再改
+enum class RouterKind : uint32_t { Modulo = 1, Mix = 2, Consistent = 3 };
+
+inline uint64_t routerLayout(RouterKind kind, size_t slices)
+{
+    return static_cast<uint64_t>(kind) << 32 | static_cast<uint32_t>(slices);
+}
+
+// 旧的路由方式：哈希值直接对分片数取模。std::hash 对整数是恒等映射，连续的 ID 会按顺序轮流落到各分片上，
+// 每次路由还要做一次除法；仅用于与旧的分片布局（以及按它保存的分片快照）保持一致
+class ModuloRouter
+{
+public:
+    static constexpr bool kResizable = false;
+
+    explicit ModuloRouter(size_t slices) : slices_(slices) {}
+
+    size_t slices() const { return slices_; }
+    size_t route(uint64_t hash) const { return hash % slices_; }
+    uint64_t snapshotLayout() const { return routerLayout(RouterKind::Modulo, slices_); }
+
+private:
+    size_t slices_;
+};
+
+// 默认路由：先混合哈希值，分片数是 2 的幂时取低位掩码，否则用高 32 位做乘法-移位映射到 [0, slices)，都不需要除法
+class MixRouter
+{
+public:
+    static constexpr bool kResizable = false;
+
+    explicit MixRouter(size_t slices)
+        : slices_(slices)
+        , mask_((slices & (slices - 1)) == 0 ? slices - 1 : 0)
+        , pow2_((slices & (slices - 1)) == 0)
+    {}
+
+    size_t slices() const { return slices_; }
+    uint64_t snapshotLayout() const { return routerLayout(RouterKind::Mix, slices_); }
+
+    size_t route(uint64_t hash) const
+    {
+        uint64_t h = mixHash(hash);
+        if (pow2_) {
+            return h & mask_;
+        }
+        return static_cast<size_t>(((h >> 32) * slices_) >> 32);
+    }
+
+private:
+    size_t   slices_;
+    uint64_t mask_;
+    bool     pow2_;
+};
+
+// 一致性哈希环：每个分片在环上放 kVirtualNodes 个虚拟结点，key 归属于顺时针方向的第一个虚拟结点。
+// 增加一个分片只会从其他分片各拿走一部分 key（合计约 1/n），删除最后一个分片时也只有它的 key 需要重新归属，
+// 分片数可以随核数增减而不必清空整个缓存。
+// 环按哈希值的高 kBucketBits 位分桶，查找先定位桶再在桶内二分，通常只比较几次
+class ConsistentRouter
+{
+public:
+    static constexpr bool kResizable = true;
+    static constexpr size_t kVirtualNodes = 128;
+
+    explicit ConsistentRouter(size_t slices)
+    {
+        points_.reserve(slices * kVirtualNodes);
+        for (slices_ = 0; slices_ < slices; ++slices_) {
+            for (size_t v = 0; v < kVirtualNodes; ++v) {
+                points_.push_back(Point{pointOf(slices_, v), static_cast<uint32_t>(slices_)});
+            }
+        }
+        rebuild();
+    }
+
+    size_t slices() const { return slices_; }
+
+    // 环只取决于分片数：增删分片后的环与直接按新分片数构造的相同
+    uint64_t snapshotLayout() const { return routerLayout(RouterKind::Consistent, slices_); }
+
+    size_t route(uint64_t hash) const
+    {
+        uint64_t h = mixHash(hash);
+        size_t bucket = static_cast<size_t>(h >> (64 - kBucketBits));
+        auto first = points_.begin() + buckets_[bucket];
+        auto last = points_.begin() + buckets_[bucket + 1];
+        auto it = std::lower_bound(first, last, h, [](const Point& p, uint64_t value) { return p.hash < value; });
+        if (it == points_.end()) {
+            it = points_.begin();   // 越过最后一个虚拟结点，绕回环的起点
+        }
+        return it->slice;
+    }
+
+    // 新分片的下标为增加前的 slices()
+    void addSlice()
+    {
+        for (size_t v = 0; v < kVirtualNodes; ++v) {
+            points_.push_back(Point{pointOf(slices_, v), static_cast<uint32_t>(slices_)});
+        }
+        ++slices_;
+        rebuild();
+    }
+
+    // 删除下标最大的分片，其余分片的下标不变
+    void removeSlice()
+    {
+        if (slices_ <= 1) {
+            return;
+        }
+        --slices_;
+        uint32_t removed = static_cast<uint32_t>(slices_);
+        points_.erase(std::remove_if(points_.begin(), points_.end(),
+                                     [removed](const Point& p) { return p.slice == removed; }),
+                      points_.end());
+        rebuild();
+    }
+
+private:
+    static constexpr size_t kBucketBits = 10;
+
+    struct Point
+    {
+        uint64_t hash;
+        uint32_t slice;
+    };
+
+    // 虚拟结点的位置只取决于 (分片, 序号)，同样的分片数总是得到同一个环
+    static uint64_t pointOf(size_t slice, size_t v)
+    {
+        return mixHash((static_cast<uint64_t>(slice) << 32 | v) + 0x9E3779B97F4A7C15ull);
+    }
+
+    void rebuild()
+    {
+        std::sort(points_.begin(), points_.end(), [](const Point& a, const Point& b) { return a.hash < b.hash; });
+        buckets_.assign((size_t(1) << kBucketBits) + 1, 0);
+        size_t p = 0;
+        for (size_t b = 0; b < (size_t(1) << kBucketBits); ++b) {
+            uint64_t start = static_cast<uint64_t>(b) << (64 - kBucketBits);
+            while (p < points_.size() && points_[p].hash < start) {
+                ++p;
+            }
+            buckets_[b] = static_cast<uint32_t>(p);
+        }
+        // 桶内没有不小于 hash 的结点时 lower_bound 返回桶的末尾，正好是下一个桶的第一个结点
+        buckets_[size_t(1) << kBucketBits] = static_cast<uint32_t>(points_.size());
+    }
+
+    size_t                slices_ = 0;
+    std::vector<Point>    points_;     // 按哈希值排序的虚拟结点
+    std::vector<uint32_t> buckets_;    // 桶 b 的第一个虚拟结点在 points_ 中的下标
+};
+
+// 路由表的读写锁：每次 get / put 只以共享方式锁住当前线程对应的条带，增删分片时再依次独占所有条带。
+// 路由不可伸缩时分片缓存不使用它（见 RouteReadGuard）
+using RouteLock = StripedSharedMutex;
+
+// Enabled 为 false（路由不可伸缩）时什么也不做，热路径上没有额外的原子操作
+template<bool Enabled>
+class RouteReadGuard
+{
+public:
+    explicit RouteReadGuard(RouteLock&) {}
+};
+
+template<>
+class RouteReadGuard<true>
+{
+public:
+    explicit RouteReadGuard(RouteLock& lock) : lock_(lock), stripe_(lock.lockShared()) {}
+    ~RouteReadGuard() { lock_.unlockShared(stripe_); }
+
+    RouteReadGuard(const RouteReadGuard&) = delete;
+    RouteReadGuard& operator=(const RouteReadGuard&) = delete;
+
+private:
+    RouteLock& lock_;
+    size_t     stripe_;
+};
+
+// 在分片之间迁移的条目；deadline 为 0 表示不过期，freq 为 LFU 分片中的有效频次（LRU 分片忽略）
+template<typename Key, typename Value>
+struct ShardEntry
+{
+    Key      key;
+    Value    value;
+    uint64_t deadline;
+    size_t   freq;
+};
+
+// 路由变化后，把 slices[first, last) 中不再归属所在分片的条目取出，按新路由写入归属分片，返回迁移的条目数。
+// 分片需提供 extractIf(pred, sink) 与 adopt(entries)；调用方持有 RouteLock 的独占锁，这里同一时刻只锁一个分片
+template<typename Key, typename Value, typename Slices, typename Router, typename HashFn>
+size_t migrateEntries(Slices& slices, size_t first, size_t last, const Router& router, HashFn hashOf)
+{
+    std::vector<std::vector<ShardEntry<Key, Value>>> moved(router.slices());
+    size_t total = 0;
+    for (size_t i = first; i < last; ++i) {
+        size_t target = 0;
+        total += slices[i]->extractIf(
+            [&](const Key& key) {
+                target = router.route(hashOf(key));
+                return target != i;
+            },
+            [&](ShardEntry<Key, Value>&& entry) { moved[target].push_back(std::move(entry)); });
+    }
+    for (size_t i = 0; i < moved.size(); ++i) {
+        if (!moved[i].empty()) {
+            slices[i]->adopt(moved[i]);
+        }
+    }
+    return total;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <memory>
+#include <utility>
+
+#include "CacheSnapshot.h"
+
+// 不可变的共享值句柄：以 LruCache<Key, SharedValue<T>> 这样的方式把值存成 shared_ptr<const T>，
+// 命中时锁内只复制句柄（一次引用计数的原子加），不再复制整个值；
+// 值被淘汰或覆盖后，已经拿到句柄的读者仍然可以安全地继续使用它。
+// 句柄指向的对象不可修改，更新值需要 put 一个新的句柄。
+template<typename T>
+using SharedValue = std::shared_ptr<const T>;
+
+template<typename T, typename... Args>
+SharedValue<T> makeSharedValue(Args&&... args)
+{
+    return std::make_shared<const T>(std::forward<Args>(args)...);
+}
+
+// 快照中先写一个字节标记句柄是否为空，非空时再按 Serializer<T> 写出指向的值
+template<typename T>
+struct Serializer<std::shared_ptr<const T>>
+{
+    static void write(SnapshotWriter& out, const std::shared_ptr<const T>& value)
+    {
+        uint8_t present = value ? 1 : 0;
+        out.writeBytes(&present, sizeof(present));
+        if (value) {
+            out.write(*value);
+        }
+    }
+
+    static bool read(SnapshotReader& in, std::shared_ptr<const T>& value)
+    {
+        uint8_t present;
+        if (!in.readBytes(&present, sizeof(present))) {
+            return false;
+        }
+        if (!present) {
+            value.reset();
+            return true;
+        }
+        T decoded;
+        if (!in.read(decoded)) {
+            return false;
+        }
+        value = std::make_shared<const T>(std::move(decoded));
+        return true;
+    }
+};
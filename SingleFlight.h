@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+// getOrLoad 的结果：Hit 为缓存命中；Loaded 为本线程或同一 key 上正在进行的加载取到了值；
+// NotFound 为 loader 返回 false（不写入缓存）；TimedOut 为等待别人的加载超时
+enum class LoadStatus { Hit, Loaded, NotFound, TimedOut };
+
+// 未命中合并（single-flight）：同一 key 的并发未命中只有第一个线程（leader）调用 loader，
+// 其余线程等待它的结果（每次加载一个 shared_future）。loader 在任何分片锁之外执行，
+// 成功后由 leader 写回缓存。
+// - loader(key, value) 返回 false 表示后端没有这个 key，所有等待者都得到 NotFound，结果不缓存；
+// - loader 抛出的异常会在 leader 和所有等待者上重新抛出，下一次未命中会重新加载；
+// - timeout 只约束等待者，leader 总是等 loader 返回（无法中断正在进行的加载）。
+// 进行中的加载表只在未命中时加锁，命中路径与普通 get 相同。
+// Cache 需要提供 bool get(Key, Value&) 与 void put(Key, Value)，且自身是线程安全的。
+template<typename Key, typename Value>
+class SingleFlight
+{
+public:
+    static constexpr std::chrono::milliseconds kNoTimeout = std::chrono::milliseconds::max();
+
+    template<typename Cache, typename Loader>
+    LoadStatus getOrLoad(Cache& cache, const Key& key, Value& value, Loader&& loader,
+                         std::chrono::milliseconds timeout = kNoTimeout)
+    {
+        if (cache.get(key, value)) {
+            return LoadStatus::Hit;
+        }
+
+        std::shared_ptr<Flight> flight;
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = flights_.find(key);
+            if (it != flights_.end()) {
+                flight = it->second;
+            } else {
+                flight = std::make_shared<Flight>();
+                flights_.emplace(key, flight);
+                leader = true;
+            }
+        }
+
+        if (!leader) {
+            coalesced_.fetch_add(1, std::memory_order_relaxed);
+            if (timeout != kNoTimeout && flight->result.wait_for(timeout) != std::future_status::ready) {
+                return LoadStatus::TimedOut;
+            }
+            if (!flight->result.get()) {
+                return LoadStatus::NotFound;
+            }
+            value = flight->value;
+            return LoadStatus::Loaded;
+        }
+        return lead(cache, key, value, loader, *flight);
+    }
+
+    // 没有调用 loader、而是等待了别人加载结果的次数
+    uint64_t coalescedWaiters() const { return coalesced_.load(std::memory_order_relaxed); }
+
+    // loader 实际被调用的次数
+    uint64_t loaderCalls() const { return loads_.load(std::memory_order_relaxed); }
+
+private:
+    struct Flight
+    {
+        std::promise<bool>      promise;
+        std::shared_future<bool> result;
+        Value                   value{};    // result 就绪前写入，就绪后只读
+
+        Flight() : result(promise.get_future().share()) {}
+    };
+
+    template<typename Cache, typename Loader>
+    LoadStatus lead(Cache& cache, const Key& key, Value& value, Loader& loader, Flight& flight)
+    {
+        bool found;
+        bool hit;
+        try {
+            // 上一轮加载可能在本线程未命中之后、登记之前刚刚完成并写回，再查一次避免重复加载
+            found = hit = cache.get(key, value);
+            if (!found) {
+                loads_.fetch_add(1, std::memory_order_relaxed);
+                found = loader(key, value);
+                if (found) {
+                    cache.put(key, value);
+                }
+            }
+        } catch (...) {
+            finish(key);
+            flight.promise.set_exception(std::current_exception());
+            throw;
+        }
+        if (found) {
+            flight.value = value;
+        }
+        // 先摘除再发布：摘除之后到达的线程要么命中刚写回的值，要么发起新一轮加载
+        finish(key);
+        flight.promise.set_value(found);
+        return hit ? LoadStatus::Hit : found ? LoadStatus::Loaded : LoadStatus::NotFound;
+    }
+
+    void finish(const Key& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flights_.erase(key);
+    }
+
+private:
+    std::mutex                                       mutex_;
+    std::unordered_map<Key, std::shared_ptr<Flight>> flights_;     // 正在进行的加载
+    std::atomic<uint64_t>                            coalesced_{0};
+    std::atomic<uint64_t>                            loads_{0};
+};
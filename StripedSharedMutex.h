@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <shared_mutex>
+#include <thread>
+
+// 条带化的读写锁：读者只以共享方式锁住当前线程对应的条带，不同线程落在不同的缓存行上，
+// 命中路径不再共同修改同一个读者计数；写者依次独占所有条带。
+// 提供 lock / unlock / try_lock，可以直接配合 std::unique_lock 使用；共享锁见 StripedSharedLock
+class StripedSharedMutex
+{
+public:
+    // 返回锁住的条带，解锁时原样交回
+    size_t lockShared()
+    {
+        size_t stripe = stripeIndex();
+        stripes_[stripe].mutex.lock_shared();
+        return stripe;
+    }
+
+    void unlockShared(size_t stripe) { stripes_[stripe].mutex.unlock_shared(); }
+
+    void lock()
+    {
+        for (Stripe& stripe : stripes_) {
+            stripe.mutex.lock();
+        }
+    }
+
+    void unlock()
+    {
+        for (Stripe& stripe : stripes_) {
+            stripe.mutex.unlock();
+        }
+    }
+
+    // 任何一个条带拿不到就放弃已经拿到的，返回 false
+    bool try_lock()
+    {
+        for (size_t i = 0; i < kStripes; ++i) {
+            if (!stripes_[i].mutex.try_lock()) {
+                while (i > 0) {
+                    stripes_[--i].mutex.unlock();
+                }
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t kStripes = 16;
+
+    struct alignas(64) Stripe
+    {
+        std::shared_mutex mutex;
+    };
+
+    static size_t stripeIndex()
+    {
+        static thread_local size_t index =
+            (std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ull) >> 60;
+        return index;
+    }
+
+    Stripe stripes_[kStripes];
+};
+
+class StripedSharedLock
+{
+public:
+    explicit StripedSharedLock(StripedSharedMutex& mutex) : mutex_(mutex), stripe_(mutex.lockShared()) {}
+    ~StripedSharedLock() { mutex_.unlockShared(stripe_); }
+
+    StripedSharedLock(const StripedSharedLock&) = delete;
+    StripedSharedLock& operator=(const StripedSharedLock&) = delete;
+
+private:
+    StripedSharedMutex& mutex_;
+    size_t              stripe_;
+};
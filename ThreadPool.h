@@ -0,0 +1,78 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定大小的后台线程池。submit 只是入队，从不等待任务执行；
+// 析构时丢弃尚未开始的任务，等待正在执行的任务结束。任务不应抛出异常。
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t threads)
+    {
+        threads = std::max<size_t>(1, threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this]() { run(); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            tasks_.clear();
+        }
+        cond_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                return;
+            }
+            tasks_.push_back(std::move(task));
+        }
+        cond_.notify_one();
+    }
+
+    size_t threadCount() const { return workers_.size(); }
+
+private:
+    void run()
+    {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                if (stopping_) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+private:
+    std::mutex                        mutex_;
+    std::condition_variable           cond_;
+    std::deque<std::function<void()>> tasks_;
+    bool                              stopping_ = false;
+    std::vector<std::thread>          workers_;     // 最后构造，保证线程启动时其他成员已就绪
+};
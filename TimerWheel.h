@@ -0,0 +1,244 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "NodePool.h"
+
+// 过期时间统一用毫秒刻度表示：进程内第一次调用时为 0，之后单调递增
+inline uint64_t expiryNow()
+{
+    static const auto origin = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - origin).count());
+}
+
+// 条目至少存活 ttl：当前刻度内已经过去的不足 1ms 的部分向上取整
+inline uint64_t expiryDeadline(std::chrono::milliseconds ttl)
+{
+    return expiryNow() + static_cast<uint64_t>(std::max<int64_t>(0, ttl.count())) + 1;
+}
+
+// 分层时间轮：kLevels 层、每层 64 个槽，第 l 层的一个槽覆盖 64^l 个刻度（1 刻度 = 1ms）。
+// 定时器按到期刻度与当前刻度最高的不同位放入对应层，上层的槽在时间走到它时整体下放（cascade），
+// 最终在第 0 层到期。插入、取消都是 O(1)，推进的开销均摊到每个定时器上为 O(kLevels)。
+// 超出顶层范围（约 12 天）的定时器先停在顶层最后一个槽，轮到时重新放置。
+// T 是到期时交给回调的内容（通常是缓存结点的下标或 key）。不加锁，由所属的缓存在自身的锁内调用。
+template<typename T>
+class TimerWheel
+{
+public:
+    using Handle = uint32_t;
+    static constexpr Handle kNone = UINT32_MAX;
+
+    TimerWheel() : current_(expiryNow())
+    {
+        std::fill(heads_, heads_ + kLevels * kSlots, kNone);
+        std::fill(occupied_, occupied_ + kLevels, 0);
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    Handle schedule(const T& item, uint64_t deadline)
+    {
+        Handle timer = pool_.allocate(item, deadline);
+        link(timer, current_ + 1);
+        return timer;
+    }
+
+    // 修改到期时间；timer 为 kNone 时新建一个
+    Handle reschedule(Handle timer, const T& item, uint64_t deadline)
+    {
+        if (timer == kNone) {
+            return schedule(item, deadline);
+        }
+        unlink(timer);
+        pool_[timer].deadline = deadline;
+        link(timer, current_ + 1);
+        return timer;
+    }
+
+    void cancel(Handle timer)
+    {
+        if (timer == kNone) {
+            return;
+        }
+        unlink(timer);
+        pool_.release(timer);
+    }
+
+    // 只有设置了定时器才读时钟，不带过期时间的条目不付出额外开销
+    bool expired(Handle timer) const { return timer != kNone && pool_[timer].deadline <= expiryNow(); }
+
+    uint64_t deadline(Handle timer) const { return pool_[timer].deadline; }
+
+    // 把时间推进到 now，对每个到期的定时器调用 onExpire(item)。
+    // 回调前定时器已经释放，回调里不要再 cancel 它；回调可以安全地调度或取消其他定时器。
+    template<typename F>
+    size_t advance(uint64_t now, F&& onExpire)
+    {
+        size_t count = 0;
+        while (current_ < now) {
+            // 直接跳到下一个有定时器到期或需要下放的刻度，空闲很久之后的推进也只走有事可做的刻度
+            uint64_t next = pool_.size() == 0 ? now + 1 : nextEventTick();
+            if (next > now) {
+                current_ = now;
+                break;
+            }
+            current_ = next;
+            // 同时跨过多层边界时先下放高层，高层落到低层当前槽里的定时器才能接着被处理
+            size_t top = 0;
+            while (top + 1 < kLevels && (current_ & ((uint64_t(1) << (kSlotBits * (top + 1))) - 1)) == 0) {
+                ++top;
+            }
+            for (size_t level = top; level >= 1; --level) {
+                cascade(level, (current_ >> (kSlotBits * level)) & kMask);
+            }
+
+            size_t bucket = current_ & kMask;
+            while (heads_[bucket] != kNone) {
+                Handle timer = heads_[bucket];
+                unlink(timer);
+                T item = pool_[timer].item;
+                pool_.release(timer);
+                onExpire(item);
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    void clear()
+    {
+        pool_.clear();
+        std::fill(heads_, heads_ + kLevels * kSlots, kNone);
+        std::fill(occupied_, occupied_ + kLevels, 0);
+        current_ = expiryNow();
+    }
+
+    size_t size() const { return pool_.size(); }
+
+    bool empty() const { return pool_.size() == 0; }
+
+private:
+    struct Timer
+    {
+        T        item;
+        uint64_t deadline;
+        Handle   prev;
+        Handle   next;
+        uint32_t bucket;    // level * kSlots + slot
+
+        Timer(const T& item, uint64_t deadline)
+            : item(item), deadline(deadline), prev(kNone), next(kNone), bucket(0)
+        {}
+    };
+
+    static constexpr size_t   kSlotBits = 6;
+    static constexpr size_t   kSlots = size_t(1) << kSlotBits;
+    static constexpr uint64_t kMask = kSlots - 1;
+    static constexpr size_t   kLevels = 5;
+
+    // 到期刻度与当前刻度在第 level+1 层以上都相同的最低层，即定时器应放的层；
+    // 顶层之上不再比较，顶层的槽按环形使用。earliest 之前到期的按 earliest 放置：
+    // 新调度时当前刻度的槽已经处理过，只能放到下一个刻度；下放时当前刻度的槽还没处理
+    void link(Handle timer, uint64_t earliest)
+    {
+        uint64_t deadline = std::max(pool_[timer].deadline, earliest);
+        size_t level = 0;
+        while (level < kLevels - 1 &&
+               (deadline >> (kSlotBits * (level + 1))) != (current_ >> (kSlotBits * (level + 1)))) {
+            ++level;
+        }
+        uint64_t slot = (deadline >> (kSlotBits * level)) & kMask;
+        if ((deadline >> (kSlotBits * level)) - (current_ >> (kSlotBits * level)) >= kSlots) {
+            // 顶层转一圈也到不了：放进最晚轮到的槽，届时再重新放置
+            slot = ((current_ >> (kSlotBits * level)) + kMask) & kMask;
+        }
+
+        size_t bucket = level * kSlots + slot;
+        Timer& t = pool_[timer];
+        t.bucket = static_cast<uint32_t>(bucket);
+        t.prev = kNone;
+        t.next = heads_[bucket];
+        if (heads_[bucket] != kNone) {
+            pool_[heads_[bucket]].prev = timer;
+        }
+        heads_[bucket] = timer;
+        occupied_[level] |= uint64_t(1) << slot;
+    }
+
+    void unlink(Handle timer)
+    {
+        Timer& t = pool_[timer];
+        if (t.prev != kNone) {
+            pool_[t.prev].next = t.next;
+        } else {
+            heads_[t.bucket] = t.next;
+            if (t.next == kNone) {
+                occupied_[t.bucket / kSlots] &= ~(uint64_t(1) << (t.bucket % kSlots));
+            }
+        }
+        if (t.next != kNone) {
+            pool_[t.next].prev = t.prev;
+        }
+    }
+
+    // current_ 之后第一个需要处理的刻度：第 0 层为最近的非空槽，上层为最近的非空槽的起点（届时下放）。
+    // 除顶层外，各层的非空槽都在当前刻度所在的槽之后、同一个上层槽之内；顶层按环形计算，当前槽算作转一圈之后
+    uint64_t nextEventTick() const
+    {
+        uint64_t next = UINT64_MAX;
+        for (size_t level = 0; level < kLevels; ++level) {
+            uint64_t bits = occupied_[level];
+            if (bits == 0) {
+                continue;
+            }
+            size_t shift = kSlotBits * level;
+            uint64_t units = current_ >> shift;
+            size_t slot = static_cast<size_t>(units & kMask);
+            uint64_t delta;
+            if (level + 1 < kLevels) {
+                uint64_t ahead = bits & ~((uint64_t(2) << slot) - 1);
+                // 不应出现；万一出现，退回到走到上一层的下一个槽，不会漏掉定时器
+                delta = ahead != 0 ? lowestBit(ahead) - slot : kSlots - slot;
+            } else {
+                uint64_t rotated = slot == 0 ? bits : (bits >> slot) | (bits << (kSlots - slot));
+                rotated &= ~uint64_t(1);
+                delta = rotated != 0 ? lowestBit(rotated) : kSlots;
+            }
+            next = std::min(next, (units + delta) << shift);
+        }
+        return next;
+    }
+
+    static size_t lowestBit(uint64_t v)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(v);
+#else
+        size_t bit = 0;
+        while (!(v & 1)) { v >>= 1; ++bit; }
+        return bit;
+#endif
+    }
+
+    // 时间走进上层的一个槽时，把其中的定时器按新的当前刻度重新放到下层
+    void cascade(size_t level, uint64_t slot)
+    {
+        size_t bucket = level * kSlots + slot;
+        while (heads_[bucket] != kNone) {
+            Handle timer = heads_[bucket];
+            unlink(timer);
+            link(timer, current_);
+        }
+    }
+
+private:
+    NodePool<Timer> pool_;
+    Handle          heads_[kLevels * kSlots];
+    uint64_t        occupied_[kLevels];     // 每层一个位图，标记哪些槽非空
+    uint64_t        current_;               // 已经处理到的刻度
+};
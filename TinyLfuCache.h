@@ -0,0 +1,400 @@
+#pragma once
+#include "Cachepolicy.h"
+#include "CacheWeigher.h"
+#include "FrequencySketch.h"
+#include "NodePool.h"
+#include "TimerWheel.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+template<typename Key, typename Value> class TinyLfuCache;
+
+template<typename Key, typename Value>
+class TinyLfuNode
+{
+private:
+    enum class Queue : uint8_t { Window, Probation, Protected };
+
+    Key key_;
+    Value value_;
+    uint32_t prev_;
+    uint32_t next_;
+    uint32_t timer_;    // 过期定时器，没有过期时间时为 kNone
+    Queue queue_;
+
+public:
+    TinyLfuNode(Key key, Value value)
+        : key_(std::move(key))
+        , value_(std::move(value))
+        , prev_(NodePool<TinyLfuNode>::kNull)
+        , next_(NodePool<TinyLfuNode>::kNull)
+        , timer_(TimerWheel<uint32_t>::kNone)
+        , queue_(Queue::Window)
+    {}
+
+    friend class TinyLfuCache<Key, Value>;
+};
+
+// W-TinyLFU：约 1% 容量的准入窗口 LRU + 分段主区 LRU（试用段 20%、保护段 80%）。
+// 新条目先进入窗口，被挤出窗口时作为候选者与试用段最久未访问的条目比较频率草图中的估计值，
+// 频率更高者留下。门卫布隆过滤器挡住只出现一次的 key，使草图只统计重复出现的访问。
+template<typename Key, typename Value>
+class TinyLfuCache : public CachePolicy<Key, Value>
+{
+public:
+    using NodeType = TinyLfuNode<Key, Value>;
+    using Queue = typename NodeType::Queue;
+    using NodePoolType = NodePool<NodeType>;
+    using NodeIndex = typename NodePoolType::Index;
+    using NodeMap = std::unordered_map<Key, NodeIndex>;
+    using WeigherType = Weigher<Key, Value>;
+
+    explicit TinyLfuCache(int capacity)
+        : TinyLfuCache(capacity > 0 ? capacity : 0, nullptr)
+    {}
+
+    // 按权重计容量：窗口、试用段、保护段的大小都按权重计；频率草图按条目数分配，
+    // 规模由容量与驻留条目的平均权重估计，见 resizeSketch
+    TinyLfuCache(size_t maxWeight, WeigherType weigher)
+        : capacity_(maxWeight)
+        , weigher_(std::move(weigher))
+        , windowCapacity_(std::max<size_t>(1, capacity_ / 100))
+        , protectedCapacity_((capacity_ - std::min(capacity_, windowCapacity_)) * 8 / 10)
+        , windowSize_(0)
+        , probationSize_(0)
+        , protectedSize_(0)
+        , sketchEntries_(weigher_ ? std::min(capacity_, kInitialSketchEntries) : capacity_)
+        , sketch_(sketchEntries_)
+        , doorkeeper_(sketchEntries_)
+    {
+        window_ = newSentinel();
+        probation_ = newSentinel();
+        protected_ = newSentinel();
+    }
+
+    ~TinyLfuCache() override = default;
+
+    void put(Key key, Value value) override
+    {
+        if (capacity_ == 0) {
+            return;
+        }
+
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer.locked();
+        expireLocked();
+        putLocked(std::move(key), std::move(value), 0);
+    }
+
+    void put(Key key, Value value, std::chrono::milliseconds ttl) override
+    {
+        if (capacity_ == 0) {
+            return;
+        }
+
+        StatsTimer timer(this->stats_, CacheStats::Op::Put);
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer.locked();
+        expireLocked();
+        putLocked(std::move(key), std::move(value), expiryDeadline(ttl));
+    }
+
+    bool get(Key key, Value& value) override
+    {
+        StatsTimer timer(this->stats_, CacheStats::Op::Get);
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer.locked();
+        recordAccess(key);
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) {
+            this->stats_.add(CacheEvent::Miss);
+            return false;
+        }
+        if (wheel_.expired(pool_[it->second].timer_)) {
+            evict(it->second);
+            this->stats_.add(CacheEvent::Expiration);
+            this->stats_.add(CacheEvent::Miss);
+            return false;
+        }
+        onHit(it->second);
+        value = pool_[it->second].value_;
+        this->stats_.add(CacheEvent::Hit);
+        return true;
+    }
+
+    Value get(Key key) override
+    {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 频率草图与门卫占用的字节数
+    size_t sketchMemoryUsage() const { return sketch_.memoryUsage() + doorkeeper_.memoryUsage(); }
+
+    size_t purgeExpired() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return expireLocked();
+    }
+
+    size_t size() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return nodeMap_.size();
+    }
+
+    size_t weightedSize() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return totalSize();
+    }
+
+private:
+    static constexpr size_t kInitialSketchEntries = 64;
+
+    // 按权重计容量时，满载的条目数估计为容量除以驻留条目的平均权重（不少于驻留条目数）。
+    // 估计值超过草图规模的 2 倍或不到 1/4 时按估计值重新分配草图与门卫，已有的频率随之清零
+    void resizeSketch()
+    {
+        if (!weigher_ || nodeMap_.empty()) {
+            return;
+        }
+        size_t avgWeight = std::max<size_t>(1, totalSize() / nodeMap_.size());
+        size_t entries = std::max(nodeMap_.size(), capacity_ / avgWeight);
+        if (entries > 2 * sketchEntries_ || 4 * entries < sketchEntries_) {
+            sketchEntries_ = entries;
+            sketch_.resize(entries);
+            doorkeeper_.resize(entries);
+        }
+    }
+
+    size_t totalSize() const { return windowSize_ + probationSize_ + protectedSize_; }
+
+    size_t weightOf(NodeIndex idx) const { return weighEntry(weigher_, pool_[idx].key_, pool_[idx].value_); }
+
+    size_t& segmentSize(Queue queue)
+    {
+        return queue == Queue::Window ? windowSize_ : queue == Queue::Probation ? probationSize_ : protectedSize_;
+    }
+
+    // 过期时间在插入链表、触发淘汰之前设好，条目随后被淘汰时定时器一并取消。deadline 为 0 表示不过期
+    template<typename K, typename V>
+    void putLocked(K&& key, V&& value, uint64_t deadline)
+    {
+        this->stats_.add(CacheEvent::Put);
+        auto it = nodeMap_.find(key);
+        if (it != nodeMap_.end()) {
+            setExpiry(it->second, deadline);
+            updateValue(it->second, std::forward<V>(value));
+            return;
+        }
+
+        recordAccess(key);
+        size_t weight = weighEntry(weigher_, key, value);
+        if (weight > capacity_) {
+            return;
+        }
+        // key 在结点和索引中各存一份：先复制进结点，再把参数本身移动进索引
+        NodeIndex idx = pool_.allocate(key, std::forward<V>(value));
+        nodeMap_.emplace(std::forward<K>(key), idx);
+        setExpiry(idx, deadline);
+        linkLast(window_, idx);
+        windowSize_ += weight;
+        evictEntries();
+        resizeSketch();
+    }
+
+    void setExpiry(NodeIndex idx, uint64_t deadline)
+    {
+        uint32_t& timer = pool_[idx].timer_;
+        if (deadline == 0) {
+            wheel_.cancel(timer);
+            timer = TimerWheel<NodeIndex>::kNone;
+        } else {
+            timer = wheel_.reschedule(timer, idx, deadline);
+        }
+    }
+
+    // 推进时间轮，回收到期的条目，让它们不再占用窗口和主区
+    size_t expireLocked()
+    {
+        if (wheel_.empty()) {
+            return 0;
+        }
+        size_t expired = wheel_.advance(expiryNow(), [this](NodeIndex idx) {
+            pool_[idx].timer_ = TimerWheel<NodeIndex>::kNone;
+            evict(idx);
+        });
+        this->stats_.add(CacheEvent::Expiration, expired);
+        return expired;
+    }
+
+    // 更新已有条目的值：单个条目超过容量时直接移除，值变大后淘汰到总权重重新满足容量
+    void updateValue(NodeIndex idx, Value value)
+    {
+        NodeType& node = pool_[idx];
+        size_t& segment = segmentSize(node.queue_);
+        segment -= weightOf(idx);
+        node.value_ = std::move(value);
+        size_t weight = weightOf(idx);
+        segment += weight;
+        if (weight > capacity_) {
+            evict(idx);
+            return;
+        }
+        onHit(idx);
+        evictEntries();
+    }
+
+    NodeIndex newSentinel()
+    {
+        NodeIndex idx = pool_.allocate(Key(), Value());
+        pool_[idx].prev_ = idx;
+        pool_[idx].next_ = idx;
+        return idx;
+    }
+
+    void unlink(NodeIndex idx)
+    {
+        NodeType& node = pool_[idx];
+        pool_[node.prev_].next_ = node.next_;
+        pool_[node.next_].prev_ = node.prev_;
+    }
+
+    // 插入到 list 的尾部（最近访问端），头部为最久未访问
+    void linkLast(NodeIndex list, NodeIndex idx)
+    {
+        NodeType& node = pool_[idx];
+        NodeType& head = pool_[list];
+        node.next_ = list;
+        node.prev_ = head.prev_;
+        pool_[head.prev_].next_ = idx;
+        head.prev_ = idx;
+    }
+
+    NodeIndex first(NodeIndex list) { return pool_[list].next_; }
+
+    void recordAccess(const Key& key)
+    {
+        uint64_t hash = std::hash<Key>()(key);
+        if (!doorkeeper_.put(hash)) {
+            return;
+        }
+        if (sketch_.increment(hash)) {
+            doorkeeper_.clear();
+            this->stats_.add(CacheEvent::AgingRun);
+        }
+    }
+
+    uint32_t frequency(const Key& key) const
+    {
+        uint64_t hash = std::hash<Key>()(key);
+        return sketch_.frequency(hash) + (doorkeeper_.contains(hash) ? 1 : 0);
+    }
+
+    void onHit(NodeIndex idx)
+    {
+        NodeType& node = pool_[idx];
+        switch (node.queue_) {
+        case Queue::Window:
+            unlink(idx);
+            linkLast(window_, idx);
+            break;
+        case Queue::Probation:
+            // 试用段再次命中：晋升到保护段，保护段溢出的条目降回试用段
+            unlink(idx);
+            node.queue_ = Queue::Protected;
+            linkLast(protected_, idx);
+            probationSize_ -= weightOf(idx);
+            protectedSize_ += weightOf(idx);
+            while (protectedSize_ > protectedCapacity_) {
+                NodeIndex demoted = first(protected_);
+                unlink(demoted);
+                pool_[demoted].queue_ = Queue::Probation;
+                linkLast(probation_, demoted);
+                protectedSize_ -= weightOf(demoted);
+                probationSize_ += weightOf(demoted);
+            }
+            break;
+        case Queue::Protected:
+            unlink(idx);
+            linkLast(protected_, idx);
+            break;
+        }
+    }
+
+    void evictEntries()
+    {
+        while (windowSize_ > windowCapacity_) {
+            NodeIndex candidate = first(window_);
+            unlink(candidate);
+            pool_[candidate].queue_ = Queue::Probation;
+            linkLast(probation_, candidate);
+            size_t weight = weightOf(candidate);
+            windowSize_ -= weight;
+            probationSize_ += weight;
+
+            // 按权重计时一个候选者可能需要挤掉多个主区条目
+            while (totalSize() > capacity_ && admitOrReject(candidate)) {}
+        }
+
+        // 主区条目的值变大也可能超出容量：此时不再比较频率，直接从各段最久未访问的一端淘汰
+        while (totalSize() > capacity_) {
+            NodeIndex list = first(probation_) != probation_ ? probation_
+                           : first(protected_) != protected_ ? protected_ : window_;
+            evict(first(list));
+            this->stats_.add(CacheEvent::Eviction);
+        }
+    }
+
+    // 候选者与主区的淘汰对象比较估计频率，频率低的一方被淘汰（相同则淘汰候选者）。
+    // 返回候选者是否仍然留在缓存中
+    bool admitOrReject(NodeIndex candidate)
+    {
+        NodeIndex victim = first(probation_);
+        if (victim == candidate) {
+            victim = first(protected_) != protected_ ? first(protected_) : candidate;
+        }
+        this->stats_.add(CacheEvent::Eviction);
+        if (victim != candidate && frequency(pool_[candidate].key_) > frequency(pool_[victim].key_)) {
+            evict(victim);
+            return true;
+        }
+        evict(candidate);
+        return false;
+    }
+
+    void evict(NodeIndex idx)
+    {
+        NodeType& node = pool_[idx];
+        unlink(idx);
+        segmentSize(node.queue_) -= weightOf(idx);
+        wheel_.cancel(node.timer_);
+        nodeMap_.erase(node.key_);
+        pool_.release(idx);
+    }
+
+private:
+    size_t          capacity_;       // 权重上限，未设置 weigher 时即条目数上限
+    WeigherType     weigher_;
+    size_t          windowCapacity_;
+    size_t          protectedCapacity_;
+    size_t          windowSize_;     // 各段的权重之和
+    size_t          probationSize_;
+    size_t          protectedSize_;
+    NodeIndex       window_;     // 各段链表的哨兵
+    NodeIndex       probation_;
+    NodeIndex       protected_;
+    NodeMap         nodeMap_;
+    NodePoolType    pool_;
+    size_t          sketchEntries_;  // 草图与门卫按多少个条目分配
+    FrequencySketch sketch_;
+    Doorkeeper      doorkeeper_;
+    TimerWheel<NodeIndex> wheel_;   // 设置了过期时间的条目
+    std::mutex      mutex_;
+};
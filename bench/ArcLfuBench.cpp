@@ -0,0 +1,90 @@
+// ArcLfuPart 频次结构微基准：所有结点处在同一频次时，get 的平均耗时应不随容量增长。
+// 每一轮按随机顺序把每个 key 访问一次，使整个缓存始终挤在一两个频次桶里。
+// 容量变大后哈希表与结点本身的 cache miss 会抬高绝对耗时，因此同时给出
+// 同样访问顺序下单纯查一次 unordered_map 的耗时作为基线，二者之差即频次结构本身的开销。
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "../ArcCache/ArcLfuPart.h"
+
+std::vector<int> shuffledKeys(size_t capacity)
+{
+    std::vector<int> order(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        order[i] = static_cast<int>(i);
+    }
+    std::mt19937 gen(42);
+    std::shuffle(order.begin(), order.end(), gen);
+    return order;
+}
+
+double nsPerLookup(size_t capacity, size_t minOps)
+{
+    std::unordered_map<int, std::shared_ptr<int>> map;
+    for (size_t key = 0; key < capacity; ++key) {
+        map[static_cast<int>(key)] = std::make_shared<int>(static_cast<int>(key));
+    }
+    std::vector<int> order = shuffledKeys(capacity);
+
+    size_t rounds = std::max<size_t>(1, minOps / capacity);
+    long long sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (int key : order) {
+            auto it = map.find(key);
+            if (it != map.end()) sink += *it->second;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (sink == 42) std::cout << "";
+    return std::chrono::duration<double, std::nano>(end - start).count() / (rounds * capacity);
+}
+
+double nsPerGet(size_t capacity, size_t minOps)
+{
+    ArcLfuPart<int, int> lfu(capacity, 2);
+    for (size_t key = 0; key < capacity; ++key) {
+        lfu.put(static_cast<int>(key), static_cast<int>(key));
+    }
+    std::vector<int> order = shuffledKeys(capacity);
+
+    size_t rounds = std::max<size_t>(1, minOps / capacity);
+    long long sink = 0;
+    int value = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (int key : order) {
+            if (lfu.get(key, value)) sink += value;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (sink == 42) std::cout << "";
+    return std::chrono::duration<double, std::nano>(end - start).count() / (rounds * capacity);
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t MIN_OPS = 2000000;
+    std::vector<size_t> capacities = {1000, 10000, 100000, 1000000};
+    if (argc > 1) {
+        capacities = {static_cast<size_t>(std::atoll(argv[1]))};
+    }
+
+    std::cout << std::left << std::setw(12) << "容量" << std::right << std::setw(12) << "ns/get"
+              << std::setw(14) << "ns/lookup" << std::setw(12) << "overhead" << std::endl;
+    for (size_t capacity : capacities) {
+        double get = nsPerGet(capacity, MIN_OPS);
+        double lookup = nsPerLookup(capacity, MIN_OPS);
+        std::cout << std::left << std::setw(12) << capacity
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << get << std::setw(14) << lookup << std::setw(12) << get - lookup << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+// 索引哈希表对比：同一策略分别使用 StdIndex（std::unordered_map）与 FlatIndex（FlatHashMap），
+// 测量命中 get 的平均耗时，以及工作集为容量 2 倍时持续淘汰的 put+get 吞吐（每次未命中都会删一插一）。
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../ArcCache/ArcCache.h"
+#include "../LfuCache.h"
+#include "../LruCache.h"
+
+std::vector<int> randomKeys(size_t count, size_t range, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::vector<int> keys(count);
+    for (auto& key : keys) {
+        key = static_cast<int>(gen() % range);
+    }
+    return keys;
+}
+
+template<typename Cache>
+double nsPerHit(size_t capacity, size_t ops)
+{
+    Cache cache(capacity);
+    for (size_t key = 0; key < capacity; ++key) {
+        cache.put(static_cast<int>(key), static_cast<int>(key));
+    }
+    std::vector<int> keys = randomKeys(ops, capacity, 42);
+
+    long long sink = 0;
+    int value = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int key : keys) {
+        if (cache.get(key, value)) sink += value;
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (sink == 42) std::cout << "";
+    return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+}
+
+template<typename Cache>
+double nsPerChurnOp(size_t capacity, size_t ops)
+{
+    Cache cache(capacity);
+    std::vector<int> keys = randomKeys(ops, capacity * 2, 7);
+
+    int value = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int key : keys) {
+        if (!cache.get(key, value)) {
+            cache.put(key, key);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+}
+
+template<template<typename, typename, typename> class Policy>
+void report(const char* name, size_t capacity, size_t ops)
+{
+    using StdCache = Policy<int, int, StdIndex>;
+    using FlatCache = Policy<int, int, FlatIndex>;
+    std::cout << std::left << std::setw(6) << name << std::setw(10) << capacity
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << nsPerHit<StdCache>(capacity, ops)
+              << std::setw(10) << nsPerHit<FlatCache>(capacity, ops)
+              << std::setw(12) << nsPerChurnOp<StdCache>(capacity, ops)
+              << std::setw(12) << nsPerChurnOp<FlatCache>(capacity, ops) << std::endl;
+}
+
+// 统一成三个模板参数的形式，便于作为模板模板参数传入
+template<typename Key, typename Value, typename Index>
+using Lru = LruCache<Key, Value, Index>;
+template<typename Key, typename Value, typename Index>
+using Lfu = LfuCache<Key, Value, Index>;
+template<typename Key, typename Value, typename Index>
+using Arc = ArcCache<Key, Value, Index>;
+
+int main(int argc, char* argv[])
+{
+    const size_t OPS = 2000000;
+    std::vector<size_t> capacities = {1000, 100000, 1000000};
+    if (argc > 1) {
+        capacities = {static_cast<size_t>(std::atoll(argv[1]))};
+    }
+
+    std::cout << std::left << std::setw(6) << "策略" << std::setw(10) << "容量" << std::right
+              << std::setw(10) << "hit/std" << std::setw(10) << "hit/flat"
+              << std::setw(12) << "churn/std" << std::setw(12) << "churn/flat" << "  (ns/op)" << std::endl;
+    for (size_t capacity : capacities) {
+        report<Lru>("LRU", capacity, OPS);
+        report<Lfu>("LFU", capacity, OPS);
+        report<Arc>("ARC", capacity, OPS);
+    }
+    return 0;
+}
@@ -0,0 +1,302 @@
+// 节点池前后对比：每个条目占用的字节数以及 get 的平均耗时。
+// "before" 为改造前以 make_shared 分配结点、shared_ptr 双向链接的 LRU/LFU 实现，
+// "after" 为当前基于 NodePool 的 LruCache / LfuCache。
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <malloc.h>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../LruCache.h"
+#include "../LfuCache.h"
+
+// 统计堆上当前存活的字节数。按分配器实际给出的大小（malloc_usable_size）计，
+// 含对齐补齐的部分；释放时同样查询，不需要在用户指针前面放头部
+static std::atomic<size_t> g_liveBytes{0};
+
+void* operator new(size_t size)
+{
+    void* ptr = std::malloc(size > 0 ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    g_liveBytes += malloc_usable_size(ptr);
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (!ptr) return;
+    g_liveBytes -= malloc_usable_size(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+
+// 改造前的 LRU：每个结点一次 make_shared，prev/next 都是 shared_ptr
+template<typename Key, typename Value>
+class LegacyLruCache
+{
+    struct Node
+    {
+        Key key;
+        Value value;
+        std::shared_ptr<Node> prev;
+        std::shared_ptr<Node> next;
+        size_t accessCount = 1;
+        Node(Key k, Value v) : key(k), value(v) {}
+    };
+    using NodePtr = std::shared_ptr<Node>;
+
+public:
+    explicit LegacyLruCache(int capacity) : capacity_(capacity)
+    {
+        head_ = std::make_shared<Node>(Key(), Value());
+        tail_ = std::make_shared<Node>(Key(), Value());
+        head_->next = tail_;
+        tail_->prev = head_;
+    }
+
+    ~LegacyLruCache()
+    {
+        // 断开环形引用，避免析构时泄漏
+        for (NodePtr node = head_; node; ) {
+            NodePtr next = node->next;
+            node->prev.reset();
+            node->next.reset();
+            node = next;
+        }
+    }
+
+    void put(Key key, Value value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = nodeMap_.find(key);
+        if (it != nodeMap_.end()) {
+            it->second->value = value;
+            moveToMostRecent(it->second);
+            return;
+        }
+        if (nodeMap_.size() >= static_cast<size_t>(capacity_)) {
+            NodePtr victim = head_->next;
+            unlink(victim);
+            victim->prev.reset();
+            victim->next.reset();
+            nodeMap_.erase(victim->key);
+        }
+        NodePtr node = std::make_shared<Node>(key, value);
+        insert(node);
+        nodeMap_[key] = node;
+    }
+
+    bool get(Key key, Value& value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) return false;
+        moveToMostRecent(it->second);
+        value = it->second->value;
+        return true;
+    }
+
+private:
+    void unlink(NodePtr node)
+    {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+    }
+    void insert(NodePtr node)
+    {
+        node->next = tail_;
+        node->prev = tail_->prev;
+        tail_->prev->next = node;
+        tail_->prev = node;
+    }
+    void moveToMostRecent(NodePtr node) { unlink(node); insert(node); }
+
+    int capacity_;
+    std::mutex mutex_;
+    std::unordered_map<Key, NodePtr> nodeMap_;
+    NodePtr head_;
+    NodePtr tail_;
+};
+
+// 改造前的 LFU：结点同样用 make_shared 分配，每个频次一条带哨兵的 shared_ptr 双向链表
+template<typename Key, typename Value>
+class LegacyLfuCache
+{
+    struct Node
+    {
+        int freq = 1;
+        Key key;
+        Value value;
+        std::shared_ptr<Node> pre;
+        std::shared_ptr<Node> next;
+        Node() = default;
+        Node(Key k, Value v) : key(k), value(v) {}
+    };
+    using NodePtr = std::shared_ptr<Node>;
+
+    struct List
+    {
+        NodePtr head = std::make_shared<Node>();
+        NodePtr tail = std::make_shared<Node>();
+        List() { head->next = tail; tail->pre = head; }
+        ~List()
+        {
+            for (NodePtr node = head; node; ) {
+                NodePtr next = node->next;
+                node->pre.reset();
+                node->next.reset();
+                node = next;
+            }
+        }
+        bool empty() const { return head->next == tail; }
+        void add(const NodePtr& node)
+        {
+            node->pre = tail->pre;
+            node->next = tail;
+            tail->pre->next = node;
+            tail->pre = node;
+        }
+        void remove(const NodePtr& node)
+        {
+            node->pre->next = node->next;
+            node->next->pre = node->pre;
+            node->pre = nullptr;
+            node->next = nullptr;
+        }
+    };
+
+public:
+    explicit LegacyLfuCache(int capacity) : capacity_(capacity) {}
+
+    void put(Key key, Value value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = nodeMap_.find(key);
+        if (it != nodeMap_.end()) {
+            it->second->value = value;
+            touch(it->second);
+            return;
+        }
+        if (nodeMap_.size() >= static_cast<size_t>(capacity_)) {
+            List& list = lists_[minFreq_];
+            NodePtr victim = list.head->next;
+            list.remove(victim);
+            nodeMap_.erase(victim->key);
+        }
+        NodePtr node = std::make_shared<Node>(key, value);
+        nodeMap_[key] = node;
+        lists_[1].add(node);
+        minFreq_ = 1;
+    }
+
+    bool get(Key key, Value& value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) return false;
+        touch(it->second);
+        value = it->second->value;
+        return true;
+    }
+
+private:
+    void touch(const NodePtr& node)
+    {
+        List& list = lists_[node->freq];
+        list.remove(node);
+        if (list.empty() && minFreq_ == node->freq) ++minFreq_;
+        ++node->freq;
+        lists_[node->freq].add(node);
+    }
+
+    int capacity_;
+    int minFreq_ = 1;
+    std::mutex mutex_;
+    std::unordered_map<Key, NodePtr> nodeMap_;
+    std::unordered_map<int, List> lists_;
+};
+
+// 旧实现没有频次老化，对比时把 LfuCache 的老化阈值调到不会触发
+template<typename Key, typename Value>
+class NoAgingLfuCache : public LfuCache<Key, Value>
+{
+public:
+    explicit NoAgingLfuCache(int capacity) : LfuCache<Key, Value>(capacity, INT32_MAX / 2) {}
+};
+
+struct BenchResult
+{
+    double bytesPerEntry;
+    double nsPerGet;
+};
+
+template<typename Cache>
+BenchResult runBench(int entries, int gets)
+{
+    size_t before = g_liveBytes.load();
+    BenchResult result{};
+    {
+        Cache cache(entries);
+        for (int key = 0; key < entries; ++key) {
+            cache.put(key, key);
+        }
+        result.bytesPerEntry = double(g_liveBytes.load() - before) / entries;
+
+        std::mt19937 gen(42);
+        std::vector<int> keys(gets);
+        for (auto& key : keys) {
+            key = gen() % entries;
+        }
+
+        long long sink = 0;
+        int value = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int key : keys) {
+            if (cache.get(key, value)) sink += value;
+        }
+        auto end = std::chrono::steady_clock::now();
+        result.nsPerGet = std::chrono::duration<double, std::nano>(end - start).count() / gets;
+        if (sink == 42) std::cout << "";
+    }
+    return result;
+}
+
+void printRow(const std::string& name, const BenchResult& r)
+{
+    std::cout << std::left << std::setw(28) << name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(1) << r.bytesPerEntry
+              << std::setw(12) << std::setprecision(1) << r.nsPerGet << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    const int GETS = 2000000;
+    std::vector<int> sizes = {1000, 100000, 1000000};
+    if (argc > 1) {
+        sizes = {std::atoi(argv[1])};
+    }
+
+    for (int entries : sizes) {
+        std::cout << "\n=== 条目数: " << entries << " ===" << std::endl;
+        std::cout << std::left << std::setw(28) << "实现"
+                  << std::right << std::setw(12) << "B/entry" << std::setw(12) << "ns/get" << std::endl;
+        printRow("LRU before (shared_ptr)", runBench<LegacyLruCache<int, int>>(entries, GETS));
+        printRow("LRU after (NodePool)", runBench<LruCache<int, int>>(entries, GETS));
+        printRow("LFU before (shared_ptr)", runBench<LegacyLfuCache<int, int>>(entries, GETS));
+        printRow("LFU after (NodePool)", runBench<NoAgingLfuCache<int, int>>(entries, GETS));
+    }
+    return 0;
+}
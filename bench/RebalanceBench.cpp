@@ -0,0 +1,96 @@
+// 分片容量再平衡对命中率的影响：key 到分片的分布刻意倾斜，两个分片各自的工作集远大于平均份额，
+// 其余分片的工作集只有份额的一半。对比不分片的缓存、固定份额的分片缓存，
+// 以及每隔 interval 次操作调用一次 rebalance() 的分片缓存（读未命中时回填）。
+//
+// 用法: RebalanceBench [ops=2000000] [interval=20000]
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../LfuCache.h"
+#include "../LruCache.h"
+
+constexpr int kSlices = 8;
+constexpr int kCapacity = 8000;
+
+using ShardedLru = LruHashCache<int, std::string, LruCache<int, std::string>, ModuloRouter>;
+using ShardedLfu = LfuHashCache<int, std::string, StdIndex, ModuloRouter>;
+
+// 分片 s 的工作集大小与被访问的概率；分片缓存使用 ModuloRouter，key % kSlices 即分片号
+const int kWorkingSet[kSlices] = {3000, 3000, 500, 500, 500, 500, 500, 500};
+const double kWeight[kSlices] = {0.3, 0.3, 0.0667, 0.0667, 0.0667, 0.0667, 0.0667, 0.0666};
+
+std::vector<int> makeKeys(size_t ops)
+{
+    std::mt19937 gen(42);
+    std::discrete_distribution<int> slice(kWeight, kWeight + kSlices);
+    std::vector<int> keys(ops);
+    for (auto& key : keys) {
+        int s = slice(gen);
+        // 工作集内部再取一点偏斜，让替换策略有区分的余地
+        std::uniform_real_distribution<double> u(0, 1);
+        int j = static_cast<int>(kWorkingSet[s] * u(gen) * u(gen));
+        key = s + kSlices * j;
+    }
+    return keys;
+}
+
+template<typename Cache, typename Maintain>
+double hitRatio(Cache& cache, const std::vector<int>& keys, size_t interval, Maintain maintain)
+{
+    size_t hits = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::string value;
+        if (cache.get(keys[i], value)) {
+            ++hits;
+        } else {
+            cache.put(keys[i], "v");
+        }
+        if (interval > 0 && (i + 1) % interval == 0) {
+            maintain();
+        }
+    }
+    return 100.0 * hits / keys.size();
+}
+
+void report(const char* name, double ratio)
+{
+    std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << ratio << "%" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t ops = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 2000000;
+    size_t interval = argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 20000;
+    std::vector<int> keys = makeKeys(ops);
+
+    {
+        LruCache<int, std::string> cache(kCapacity);
+        report("LRU 不分片", hitRatio(cache, keys, 0, [] {}));
+    }
+    {
+        ShardedLru cache(kCapacity, kSlices);
+        report("LRU 分片固定份额", hitRatio(cache, keys, 0, [] {}));
+    }
+    {
+        ShardedLru cache(kCapacity, kSlices);
+        report("LRU 分片再平衡", hitRatio(cache, keys, interval, [&] { cache.rebalance(); }));
+    }
+    {
+        LfuCache<int, std::string> cache(kCapacity);
+        report("LFU 不分片", hitRatio(cache, keys, 0, [] {}));
+    }
+    {
+        ShardedLfu cache(kCapacity, kSlices);
+        report("LFU 分片固定份额", hitRatio(cache, keys, 0, [] {}));
+    }
+    {
+        ShardedLfu cache(kCapacity, kSlices);
+        report("LFU 分片再平衡", hitRatio(cache, keys, interval, [&] { cache.rebalance(); }));
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+// 分片路由对比：
+//   1. 均衡度：按步长递增的整数 ID（步长为 1 与分片数的倍数两种）落到各分片后，最大分片与平均值之比
+//   2. 路由开销：每次 route 的平均耗时
+//   3. 一致性哈希增删分片：填满后增加 / 删除一个分片，迁移的条目比例与之后仍能命中的比例
+//
+// 用法: ShardRouterBench [keys=1000000] [slices=8]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../LruCache.h"
+#include "../ShardRouter.h"
+
+template<typename Router>
+double imbalance(const Router& router, size_t keys, uint64_t stride)
+{
+    std::vector<size_t> counts(router.slices(), 0);
+    for (uint64_t i = 0; i < keys; ++i) {
+        ++counts[router.route(i * stride)];
+    }
+    size_t maxCount = *std::max_element(counts.begin(), counts.end());
+    return static_cast<double>(maxCount) * router.slices() / keys;
+}
+
+volatile size_t gSink;
+
+template<typename Router>
+double nsPerRoute(const Router& router, size_t keys)
+{
+    size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 10; ++round) {
+        for (uint64_t i = 0; i < keys; ++i) {
+            sink += router.route(i * 0x9E3779B97F4A7C15ull);
+        }
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    gSink = sink;   // 防止循环被整个优化掉
+    return elapsed / (10.0 * keys);
+}
+
+template<typename Router>
+void reportRouter(const char* name, size_t keys, size_t slices)
+{
+    Router router(slices);
+    std::cout << std::left << std::setw(18) << name << std::right << std::fixed << std::setprecision(3)
+              << "  max/avg(步长1) " << std::setw(6) << imbalance(router, keys, 1)
+              << "  max/avg(步长" << slices << ") " << std::setw(6) << imbalance(router, keys, slices)
+              << std::setprecision(2) << "  " << std::setw(6) << nsPerRoute(router, keys) << " ns/route"
+              << std::endl;
+}
+
+size_t countHits(LruHashCache<int, int, LruCache<int, int>, ConsistentRouter>& cache, int keys)
+{
+    size_t hits = 0;
+    int value;
+    for (int i = 0; i < keys; ++i) {
+        hits += cache.get(i, value);
+    }
+    return hits;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t keys = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 1000000;
+    size_t slices = argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 8;
+
+    reportRouter<ModuloRouter>("ModuloRouter", keys, slices);
+    reportRouter<MixRouter>("MixRouter", keys, slices);
+    reportRouter<MixRouter>("MixRouter(非2的幂)", keys, slices + 1);
+    reportRouter<ConsistentRouter>("ConsistentRouter", keys, slices);
+
+    // 容量留出余量，增删分片后各分片的份额波动不会引起淘汰，命中率的损失只来自迁移本身
+    int entries = static_cast<int>(keys / 10);
+    LruHashCache<int, int, LruCache<int, int>, ConsistentRouter> cache(entries * 2, slices);
+    for (int i = 0; i < entries; ++i) {
+        cache.put(i, i);
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t moved = cache.addSlice();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "addSlice " << slices << " -> " << cache.sliceCount() << ": 迁移 " << std::setprecision(2)
+              << 100.0 * moved / entries << "% 的条目, " << ms << " ms, 命中 "
+              << 100.0 * countHits(cache, entries) / entries << "%" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    moved = cache.removeSlice();
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "removeSlice " << slices + 1 << " -> " << cache.sliceCount() << ": 迁移 "
+              << 100.0 * moved / entries << "% 的条目, " << ms << " ms, 命中 "
+              << 100.0 * countHits(cache, entries) / entries << "%" << std::endl;
+    return 0;
+}
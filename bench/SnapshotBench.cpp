@@ -0,0 +1,93 @@
+// 快照保存 / 恢复耗时：把缓存填满 entries 个条目后保存到文件，再加载到一个新实例中，
+// 与逐条 put 重新预热同样多的条目对比。分片缓存的各个分片并行编码和解码。
+//
+// 用法: SnapshotBench [entries=2000000] [path=/tmp/CacheSnapshotBench.snap]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/stat.h>
+
+#include "../ArcCache/ArcCache.h"
+#include "../LfuCache.h"
+#include "../LruCache.h"
+
+template<typename F>
+double elapsedMs(F&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+std::string valueOf(int key)
+{
+    return "value-" + std::to_string(key) + "-payload-payload";
+}
+
+template<typename Make>
+void report(const char* name, size_t entries, const std::string& path, Make make)
+{
+    auto source = make();
+    double warmMs = elapsedMs([&]() {
+        for (size_t i = 0; i < entries; ++i) {
+            source->put(static_cast<int>(i), valueOf(static_cast<int>(i)));
+        }
+    });
+    // 制造一些频次差异，让 LFU / ARC 的恢复路径不只是一个桶
+    for (size_t i = 0; i < entries; i += 7) {
+        std::string value;
+        source->get(static_cast<int>(i), value);
+    }
+
+    bool saved = false;
+    double saveMs = elapsedMs([&]() { saved = source->saveSnapshot(path); });
+    struct stat st;
+    double mb = saved && ::stat(path.c_str(), &st) == 0 ? st.st_size / 1048576.0 : 0;
+
+    auto target = make();
+    bool loaded = false;
+    double loadMs = elapsedMs([&]() { loaded = target->loadSnapshot(path); });
+    std::remove(path.c_str());
+
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << source->size() << std::setw(12) << target->size()
+              << std::setw(10) << mb << std::setw(12) << warmMs << std::setw(12) << saveMs
+              << std::setw(12) << loadMs << (saved && loaded ? "" : "  失败") << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t entries = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 2000000;
+    std::string path = argc > 2 ? argv[2] : "/tmp/CacheSnapshotBench.snap";
+    size_t slices = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+    std::cout << std::left << std::setw(10) << "策略" << std::right << std::setw(12) << "条目"
+              << std::setw(12) << "恢复条目" << std::setw(10) << "MB" << std::setw(12) << "put 预热"
+              << std::setw(12) << "保存" << std::setw(12) << "加载" << "  (ms)" << std::endl;
+
+    report("LRU", entries, path, [&]() {
+        return std::make_unique<LruCache<int, std::string>>(static_cast<int>(entries));
+    });
+    report("LFU", entries, path, [&]() {
+        return std::make_unique<LfuCache<int, std::string>>(static_cast<int>(entries));
+    });
+    report("ARC", entries, path, [&]() {
+        return std::make_unique<ArcCache<int, std::string>>(entries);
+    });
+    report("LRU-hash", entries, path, [&]() {
+        return std::make_unique<LruHashCache<int, std::string>>(static_cast<int>(entries), slices);
+    });
+    report("LFU-hash", entries, path, [&]() {
+        return std::make_unique<LfuHashCache<int, std::string>>(static_cast<int>(entries), slices);
+    });
+    report("ARC-hash", entries, path, [&]() {
+        return std::make_unique<ArcHashCache<int, std::string>>(entries, slices);
+    });
+    return 0;
+}
@@ -0,0 +1,307 @@
+// 多线程吞吐与尾延迟基准：N 个线程对同一个缓存执行读写混合负载，输出 ops/sec 随线程数的变化
+// 以及 p50/p99/p999 延迟。读操作未命中时回填（cache-aside），写操作直接 put。
+// key 序列在计时前按分布预先生成，计时区间内只有缓存操作本身和两次取时钟。
+//
+// 用法: ThroughputBench [--policy=lru] [--threads=1,2,4,8] [--capacity=100000] [--keys=1000000]
+//                       [--read=0.9] [--dist=zipf|uniform|hotspot|scan] [--skew=0.99]
+//                       [--hot-keys=0.1] [--hot-ops=0.9] [--seconds=2] [--slices=0]
+// policy: lru lfu arc arc-unified tinylfu clock clockpro s3fifo lru-rb lru-hash lfu-hash arc-hash arc-hash-global
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../ArcCache/ArcCache.h"
+#include "../ArcCache/UnifiedArcCache.h"
+#include "../ClockCache.h"
+#include "../LatencyHistogram.h"
+#include "../LfuCache.h"
+#include "../LruCache.h"
+#include "../ReadBufferedCache.h"
+#include "../S3FifoCache.h"
+#include "../TinyLfuCache.h"
+
+struct Options
+{
+    std::string         policy = "lru";
+    std::vector<size_t> threads = {1, 2, 4, 8};
+    size_t              capacity = 100000;
+    size_t              keys = 1000000;
+    double              readRatio = 0.9;
+    std::string         dist = "zipf";
+    double              skew = 0.99;
+    double              hotKeys = 0.1;
+    double              hotOps = 0.9;
+    double              seconds = 2.0;
+    size_t              slices = 0;
+};
+
+// 每个线程预生成的操作序列长度，循环使用
+constexpr size_t kOpsPerThread = 1 << 20;
+
+class KeyGenerator
+{
+public:
+    explicit KeyGenerator(const Options& opt)
+        : opt_(opt)
+    {
+        if (opt.dist == "zipf") {
+            // 预先计算累积分布，按二分查找采样；排名与 key 之间再打乱一次，避免热点集中在小 key 上
+            cdf_.resize(opt.keys);
+            double sum = 0;
+            for (size_t i = 0; i < opt.keys; ++i) {
+                sum += 1.0 / std::pow(static_cast<double>(i + 1), opt.skew);
+                cdf_[i] = sum;
+            }
+            for (auto& c : cdf_) {
+                c /= sum;
+            }
+        }
+    }
+
+    std::vector<int> generate(unsigned seed, size_t threadIndex) const
+    {
+        std::mt19937_64 gen(seed);
+        std::uniform_real_distribution<double> real(0.0, 1.0);
+        std::vector<int> out(kOpsPerThread);
+        size_t hotCount = std::min(opt_.keys, std::max<size_t>(1, static_cast<size_t>(opt_.keys * opt_.hotKeys)));
+        size_t scanPos = threadIndex * (opt_.keys / 16 + 1);
+
+        for (auto& key : out) {
+            uint64_t k;
+            if (opt_.dist == "zipf") {
+                size_t rank = std::lower_bound(cdf_.begin(), cdf_.end(), real(gen)) - cdf_.begin();
+                k = scramble(std::min(rank, opt_.keys - 1));
+            } else if (opt_.dist == "hotspot") {
+                // 冷数据取 [hotCount, keys)；热点占满整个 key 空间时只有热点
+                bool hot = hotCount == opt_.keys || real(gen) < opt_.hotOps;
+                k = hot ? gen() % hotCount : hotCount + gen() % (opt_.keys - hotCount);
+            } else if (opt_.dist == "scan") {
+                k = scanPos++ % opt_.keys;
+            } else {
+                k = gen() % opt_.keys;
+            }
+            key = static_cast<int>(k % opt_.keys);
+        }
+        return out;
+    }
+
+private:
+    uint64_t scramble(uint64_t rank) const { return mixHash(rank) % opt_.keys; }
+
+    const Options&      opt_;
+    std::vector<double> cdf_;
+};
+
+struct ThreadResult
+{
+    LatencyHistogram latency;
+    uint64_t         ops = 0;
+    uint64_t         reads = 0;
+    uint64_t         hits = 0;
+};
+
+template<typename Cache>
+void runScenario(Cache& cache, const Options& opt, size_t threadCount,
+                 const std::vector<std::vector<int>>& keys, const std::vector<std::vector<uint8_t>>& isRead)
+{
+    // 预热：按同样的分布先填满缓存
+    int value = 0;
+    for (size_t i = 0; i < std::min(kOpsPerThread, opt.capacity * 2); ++i) {
+        int key = keys[0][i];
+        if (!cache.get(key, value)) cache.put(key, key);
+    }
+
+    std::vector<std::unique_ptr<ThreadResult>> results;
+    for (size_t t = 0; t < threadCount; ++t) {
+        results.emplace_back(new ThreadResult());
+    }
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&, t] {
+            ThreadResult& r = *results[t];
+            const std::vector<int>& ks = keys[t];
+            const std::vector<uint8_t>& rs = isRead[t];
+            int v = 0;
+            ++ready;
+            while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            for (size_t i = 0; !stop.load(std::memory_order_relaxed); i = (i + 1) & (kOpsPerThread - 1)) {
+                int key = ks[i];
+                auto begin = std::chrono::steady_clock::now();
+                if (rs[i]) {
+                    ++r.reads;
+                    if (cache.get(key, v)) {
+                        ++r.hits;
+                    } else {
+                        cache.put(key, key);
+                    }
+                } else {
+                    cache.put(key, key);
+                }
+                auto end = std::chrono::steady_clock::now();
+                r.latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+                ++r.ops;
+            }
+        });
+    }
+
+    while (ready.load() != threadCount) std::this_thread::yield();
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(opt.seconds));
+    stop.store(true);
+    for (auto& w : workers) {
+        w.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    ThreadResult total;
+    for (auto& r : results) {
+        total.latency.merge(r->latency);
+        total.ops += r->ops;
+        total.reads += r->reads;
+        total.hits += r->hits;
+    }
+
+    std::cout << std::right << std::setw(8) << threadCount
+              << std::fixed << std::setprecision(0) << std::setw(14) << total.ops / elapsed
+              << std::setprecision(2) << std::setw(10) << (total.reads ? 100.0 * total.hits / total.reads : 0.0)
+              << std::setw(10) << total.latency.percentile(0.50)
+              << std::setw(10) << total.latency.percentile(0.99)
+              << std::setw(10) << total.latency.percentile(0.999)
+              << std::setw(12) << total.latency.max() << std::endl;
+}
+
+template<typename Factory>
+void runAll(const Options& opt, Factory makeCache)
+{
+    KeyGenerator generator(opt);
+    size_t maxThreads = *std::max_element(opt.threads.begin(), opt.threads.end());
+    std::vector<std::vector<int>> keys;
+    std::vector<std::vector<uint8_t>> isRead;
+    std::mt19937 gen(12345);
+    std::uniform_real_distribution<double> real(0.0, 1.0);
+    for (size_t t = 0; t < maxThreads; ++t) {
+        keys.push_back(generator.generate(1000 + static_cast<unsigned>(t), t));
+        std::vector<uint8_t> reads(kOpsPerThread);
+        for (auto& r : reads) {
+            r = real(gen) < opt.readRatio;
+        }
+        isRead.push_back(std::move(reads));
+    }
+
+    std::cout << "policy=" << opt.policy << " capacity=" << opt.capacity << " keys=" << opt.keys
+              << " read=" << opt.readRatio << " dist=" << opt.dist;
+    if (opt.dist == "zipf") std::cout << " skew=" << opt.skew;
+    if (opt.dist == "hotspot") std::cout << " hot-keys=" << opt.hotKeys << " hot-ops=" << opt.hotOps;
+    std::cout << std::endl;
+    std::cout << std::right << std::setw(8) << "threads" << std::setw(14) << "ops/sec" << std::setw(10) << "hit%"
+              << std::setw(10) << "p50(ns)" << std::setw(10) << "p99(ns)" << std::setw(10) << "p999(ns)"
+              << std::setw(12) << "max(ns)" << std::endl;
+
+    for (size_t threadCount : opt.threads) {
+        auto cache = makeCache();
+        runScenario(*cache, opt, threadCount, keys, isRead);
+    }
+}
+
+std::vector<size_t> parseList(const std::string& s)
+{
+    std::vector<size_t> out;
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t comma = s.find(',', pos);
+        if (comma == std::string::npos) comma = s.size();
+        out.push_back(std::strtoull(s.substr(pos, comma - pos).c_str(), nullptr, 10));
+        pos = comma + 1;
+    }
+    return out;
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (name == "--policy") opt.policy = value;
+        else if (name == "--threads") opt.threads = parseList(value);
+        else if (name == "--capacity") opt.capacity = std::strtoull(value.c_str(), nullptr, 10);
+        else if (name == "--keys") opt.keys = std::strtoull(value.c_str(), nullptr, 10);
+        else if (name == "--read") opt.readRatio = std::atof(value.c_str());
+        else if (name == "--dist") opt.dist = value;
+        else if (name == "--skew") opt.skew = std::atof(value.c_str());
+        else if (name == "--hot-keys") opt.hotKeys = std::atof(value.c_str());
+        else if (name == "--hot-ops") opt.hotOps = std::atof(value.c_str());
+        else if (name == "--seconds") opt.seconds = std::atof(value.c_str());
+        else if (name == "--slices") opt.slices = std::strtoull(value.c_str(), nullptr, 10);
+        else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return false;
+        }
+    }
+    if (opt.threads.empty() || opt.keys == 0 || opt.capacity == 0) {
+        std::cerr << "threads/keys/capacity 不能为空或 0" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        return 1;
+    }
+    int capacity = static_cast<int>(opt.capacity);
+    const std::string& p = opt.policy;
+
+    if (p == "lru") {
+        runAll(opt, [&] { return std::make_unique<LruCache<int, int>>(capacity); });
+    } else if (p == "lfu") {
+        runAll(opt, [&] { return std::make_unique<LfuCache<int, int>>(capacity); });
+    } else if (p == "arc") {
+        // 单个 ArcCache 的幽灵检查不在锁内，多线程下用单分片的 ArcHashCache（分片锁覆盖整个操作）
+        runAll(opt, [&] { return std::make_unique<ArcHashCache<int, int>>(opt.capacity, 1); });
+    } else if (p == "arc-unified") {
+        runAll(opt, [&] { return std::make_unique<UnifiedArcCache<int, int>>(capacity); });
+    } else if (p == "tinylfu") {
+        runAll(opt, [&] { return std::make_unique<TinyLfuCache<int, int>>(capacity); });
+    } else if (p == "clock") {
+        runAll(opt, [&] { return std::make_unique<ClockCache<int, int>>(capacity); });
+    } else if (p == "clockpro") {
+        runAll(opt, [&] { return std::make_unique<ClockProCache<int, int>>(capacity); });
+    } else if (p == "s3fifo") {
+        runAll(opt, [&] { return std::make_unique<S3FifoCache<int, int>>(capacity); });
+    } else if (p == "lru-rb") {
+        runAll(opt, [&] { return std::make_unique<ReadBufferedCache<int, int, LruCache<int, int>>>(capacity); });
+    } else if (p == "lru-hash") {
+        runAll(opt, [&] { return std::make_unique<LruHashCache<int, int>>(capacity, opt.slices); });
+    } else if (p == "lfu-hash") {
+        runAll(opt, [&] { return std::make_unique<LfuHashCache<int, int>>(capacity, opt.slices); });
+    } else if (p == "arc-hash") {
+        runAll(opt, [&] { return std::make_unique<ArcHashCache<int, int>>(opt.capacity, opt.slices); });
+    } else if (p == "arc-hash-global") {
+        runAll(opt, [&] { return std::make_unique<ArcHashCache<int, int>>(opt.capacity, opt.slices, 2, true); });
+    } else {
+        std::cerr << "未知策略: " << p << std::endl;
+        return 1;
+    }
+    return 0;
+}
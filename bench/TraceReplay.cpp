@@ -0,0 +1,330 @@
+// 访问轨迹回放：把真实的访问轨迹流式地喂给缓存策略，统计命中率、字节命中率与回放速度。
+// 输入文件通过 mmap 映射，逐行解析，不把整个文件读进内存；多个（策略, 容量）组合各占一个线程，
+// 共享同一份映射，互不干扰。
+//
+// 支持的格式（--format）：
+//   lines  每行一个 key，可以是整数或任意字符串
+//   arc    ARC 论文使用的轨迹格式: "起始块号 块数 忽略 请求号"，每个块视为一次访问
+//   csv    timestamp,key,size,op；op 为 get/read 时按读处理（未命中回填），set/put/write 时直接写入
+//
+// 用法: TraceReplay <trace> [--format=lines|arc|csv] [--policies=lru,lfu,arc]
+//                   [--capacities=1000,10000] [--jobs=N] [--limit=N] [--slices=0]
+// policies: lru lfu arc tinylfu clock clockpro lru-hash lfu-hash arc-hash
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../ArcCache/ArcCache.h"
+#include "../ClockCache.h"
+#include "../LfuCache.h"
+#include "../LruCache.h"
+#include "../MappedFile.h"
+#include "../TinyLfuCache.h"
+
+enum class TraceFormat { Lines, Arc, Csv };
+
+struct Request
+{
+    uint64_t key;
+    uint32_t size;
+    bool     isGet;
+};
+
+// 逐行解析映射区域，每解析出一次访问就回调 fn(const Request&)；fn 返回 false 时提前结束
+class TraceReader
+{
+public:
+    TraceReader(const MappedFile& file, TraceFormat format)
+        : file_(file), format_(format)
+    {}
+
+    template<typename Fn>
+    void forEach(Fn fn) const
+    {
+        const char* p = file_.data();
+        const char* end = p + file_.size();
+        while (p < end) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (!eol) eol = end;
+            std::string_view line(p, eol - p);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            p = eol + 1;
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            if (!parseLine(line, fn)) {
+                return;
+            }
+        }
+    }
+
+private:
+    template<typename Fn>
+    bool parseLine(std::string_view line, Fn& fn) const
+    {
+        switch (format_) {
+        case TraceFormat::Lines:
+            return fn(Request{keyOf(trim(line)), 1, true});
+        case TraceFormat::Arc: {
+            std::string_view fields[4];
+            if (split(line, ' ', fields, 4) < 2) return true;
+            uint64_t start = 0, count = 0;
+            if (!parseNumber(fields[0], start) || !parseNumber(fields[1], count)) return true;
+            for (uint64_t block = start; block < start + count; ++block) {
+                if (!fn(Request{block, 1, true})) return false;
+            }
+            return true;
+        }
+        case TraceFormat::Csv: {
+            std::string_view fields[4];
+            if (split(line, ',', fields, 4) < 2) return true;
+            std::string_view ts = trim(fields[0]);
+            if (ts.empty() || ts[0] < '0' || ts[0] > '9') return true;  // 表头
+            uint64_t size = 1;
+            if (!parseNumber(fields[2], size) || size == 0) size = 1;
+            std::string_view op = trim(fields[3]);
+            bool isGet = op.empty() || op == "get" || op == "GET" || op == "read" || op == "READ";
+            return fn(Request{keyOf(trim(fields[1])), static_cast<uint32_t>(std::min<uint64_t>(size, UINT32_MAX)), isGet});
+        }
+        }
+        return true;
+    }
+
+    static std::string_view trim(std::string_view s)
+    {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+        return s;
+    }
+
+    // 按分隔符切分（连续空格视为一个分隔符），返回字段数
+    static size_t split(std::string_view line, char sep, std::string_view* fields, size_t maxFields)
+    {
+        size_t n = 0;
+        size_t pos = 0;
+        while (pos <= line.size() && n < maxFields) {
+            if (sep == ' ') {
+                while (pos < line.size() && line[pos] == ' ') ++pos;
+                if (pos == line.size()) break;
+            }
+            size_t next = line.find(sep, pos);
+            if (next == std::string_view::npos) next = line.size();
+            fields[n++] = line.substr(pos, next - pos);
+            pos = next + 1;
+        }
+        for (size_t i = n; i < maxFields; ++i) fields[i] = std::string_view();
+        return n;
+    }
+
+    static bool parseNumber(std::string_view s, uint64_t& out)
+    {
+        s = trim(s);
+        if (s.empty()) return false;
+        uint64_t v = 0;
+        for (char c : s) {
+            if (c < '0' || c > '9') return false;
+            v = v * 10 + static_cast<uint64_t>(c - '0');
+        }
+        out = v;
+        return true;
+    }
+
+    // 纯数字的 key 直接使用，其余按字符串哈希成 64 位（碰撞概率可忽略）
+    static uint64_t keyOf(std::string_view s)
+    {
+        uint64_t v;
+        return parseNumber(s, v) ? v : std::hash<std::string_view>()(s);
+    }
+
+    const MappedFile& file_;
+    TraceFormat       format_;
+};
+
+struct ReplayResult
+{
+    std::string policy;
+    size_t      capacity = 0;
+    uint64_t    gets = 0;
+    uint64_t    hits = 0;
+    uint64_t    bytes = 0;
+    uint64_t    hitBytes = 0;
+    uint64_t    requests = 0;
+    double      seconds = 0;
+};
+
+// value 存对象大小，字节命中率按命中请求的 size 累计
+template<typename Cache>
+void replay(Cache& cache, const TraceReader& reader, uint64_t limit, ReplayResult& result)
+{
+    auto begin = std::chrono::steady_clock::now();
+    uint32_t cached = 0;
+    reader.forEach([&](const Request& req) {
+        if (req.isGet) {
+            ++result.gets;
+            result.bytes += req.size;
+            if (cache.get(req.key, cached)) {
+                ++result.hits;
+                result.hitBytes += req.size;
+            } else {
+                cache.put(req.key, req.size);
+            }
+        } else {
+            cache.put(req.key, req.size);
+        }
+        return ++result.requests < limit;
+    });
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+bool runPolicy(const std::string& policy, size_t capacity, size_t slices,
+               const TraceReader& reader, uint64_t limit, ReplayResult& result)
+{
+    using K = uint64_t;
+    using V = uint32_t;
+    int cap = static_cast<int>(capacity);
+    result.policy = policy;
+    result.capacity = capacity;
+
+    if (policy == "lru") {
+        LruCache<K, V> cache(cap);
+        replay(cache, reader, limit, result);
+    } else if (policy == "lfu") {
+        LfuCache<K, V> cache(cap);
+        replay(cache, reader, limit, result);
+    } else if (policy == "arc") {
+        ArcCache<K, V> cache(capacity);
+        replay(cache, reader, limit, result);
+    } else if (policy == "tinylfu") {
+        TinyLfuCache<K, V> cache(cap);
+        replay(cache, reader, limit, result);
+    } else if (policy == "clock") {
+        ClockCache<K, V> cache(cap);
+        replay(cache, reader, limit, result);
+    } else if (policy == "clockpro") {
+        ClockProCache<K, V> cache(cap);
+        replay(cache, reader, limit, result);
+    } else if (policy == "lru-hash") {
+        LruHashCache<K, V> cache(cap, slices);
+        replay(cache, reader, limit, result);
+    } else if (policy == "lfu-hash") {
+        LfuHashCache<K, V> cache(cap, slices);
+        replay(cache, reader, limit, result);
+    } else if (policy == "arc-hash") {
+        ArcHashCache<K, V> cache(capacity, slices);
+        replay(cache, reader, limit, result);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> splitList(const std::string& s)
+{
+    std::vector<std::string> out;
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t comma = s.find(',', pos);
+        if (comma == std::string::npos) comma = s.size();
+        if (comma > pos) out.push_back(s.substr(pos, comma - pos));
+        pos = comma + 1;
+    }
+    return out;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <trace> [--format=lines|arc|csv] [--policies=lru,lfu,arc]"
+                  << " [--capacities=1000,10000] [--jobs=N] [--limit=N] [--slices=0]" << std::endl;
+        return 1;
+    }
+
+    std::string path = argv[1];
+    TraceFormat format = TraceFormat::Lines;
+    std::vector<std::string> policies = {"lru", "lfu", "arc"};
+    std::vector<size_t> capacities = {1000, 10000};
+    size_t jobs = std::max<size_t>(1, std::thread::hardware_concurrency());
+    uint64_t limit = UINT64_MAX;
+    size_t slices = 0;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (name == "--format") {
+            if (value == "lines") format = TraceFormat::Lines;
+            else if (value == "arc") format = TraceFormat::Arc;
+            else if (value == "csv") format = TraceFormat::Csv;
+            else { std::cerr << "未知格式: " << value << std::endl; return 1; }
+        } else if (name == "--policies") {
+            policies = splitList(value);
+        } else if (name == "--capacities") {
+            capacities.clear();
+            for (auto& c : splitList(value)) capacities.push_back(std::strtoull(c.c_str(), nullptr, 10));
+        } else if (name == "--jobs") {
+            jobs = std::max<size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+        } else if (name == "--limit") {
+            limit = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--slices") {
+            slices = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    MappedFile file(path);
+    if (!file.valid()) {
+        std::cerr << "无法映射文件: " << path << std::endl;
+        return 1;
+    }
+    TraceReader reader(file, format);
+
+    // 每个（策略, 容量）组合是一个任务，最多 jobs 个线程同时回放
+    std::vector<ReplayResult> results(policies.size() * capacities.size());
+    std::vector<char> ok(results.size(), 1);
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < std::min(jobs, results.size()); ++t) {
+        workers.emplace_back([&] {
+            for (size_t task = next++; task < results.size(); task = next++) {
+                const std::string& policy = policies[task / capacities.size()];
+                size_t capacity = capacities[task % capacities.size()];
+                ok[task] = runPolicy(policy, capacity, slices, reader, limit, results[task]);
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    std::cout << std::left << std::setw(10) << "policy" << std::right << std::setw(12) << "capacity"
+              << std::setw(14) << "gets" << std::setw(10) << "hit%" << std::setw(12) << "byte hit%"
+              << std::setw(14) << "ops/sec" << std::endl;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ReplayResult& r = results[i];
+        if (!ok[i]) {
+            std::cout << std::left << std::setw(10) << r.policy << "  未知策略" << std::endl;
+            continue;
+        }
+        std::cout << std::left << std::setw(10) << r.policy << std::right << std::setw(12) << r.capacity
+                  << std::setw(14) << r.gets << std::fixed << std::setprecision(2)
+                  << std::setw(10) << (r.gets ? 100.0 * r.hits / r.gets : 0.0)
+                  << std::setw(12) << (r.bytes ? 100.0 * r.hitBytes / r.bytes : 0.0)
+                  << std::setprecision(0) << std::setw(14) << (r.seconds > 0 ? r.requests / r.seconds : 0.0)
+                  << std::endl;
+    }
+    return 0;
+}
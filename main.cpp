@@ -11,6 +11,10 @@
 #include "LruCache.h"
 #include "LfuCache.h"
 #include "ArcCache/ArcCache.h"
+#include "ArcCache/UnifiedArcCache.h"
+#include "TinyLfuCache.h"
+#include "SampledCache.h"
+#include "S3FifoCache.h"
 
 class Timer{
 public:
@@ -18,22 +22,23 @@ public:
 
     double elapsed() {
         auto now = std::chrono::high_resolution_clock::now();
-        return std::chrono::duration_cast<std::chrono::milliseconds>(now - start_).count();
+        return std::chrono::duration<double, std::milli>(now - start_).count();
     }
 private:
     std::chrono::time_point<std::chrono::high_resolution_clock> start_;
 };
 
+const std::array<const char*, 8> kPolicyNames = {"LRU", "LFU", "ARC", "ARC-Unified", "W-TinyLFU", "Sampled-LRU",
+                                                  "Sampled-LFU", "S3-FIFO"};
+
 void printResults(const std::string& testName, int capacity,
                   const std::vector<int>& get_operations,
                   const std::vector<int>& hits){
     std::cout << "缓存大小: " << capacity << std::endl;
-    std::cout << "LRU - 命中率: " << std::fixed << std::setprecision(2) 
-              << (100.0 * hits[0] / get_operations[0]) << "%" << std::endl;
-    std::cout << "LFU - 命中率: " << std::fixed << std::setprecision(2) 
-              << (100.0 * hits[1] / get_operations[1]) << "%" << std::endl;
-    std::cout << "ARC - 命中率: " << std::fixed << std::setprecision(2) 
-              << (100.0 * hits[2] / get_operations[2]) << "%" << std::endl;
+    for (size_t i = 0; i < kPolicyNames.size(); ++i) {
+        std::cout << kPolicyNames[i] << " - 命中率: " << std::fixed << std::setprecision(2)
+                  << (100.0 * hits[i] / get_operations[i]) << "%" << std::endl;
+    }
 }
 
 void testHotDataAccess() {
@@ -47,13 +52,19 @@ void testHotDataAccess() {
     LruCache<int, std::string> lru(CAPACITY);
     LfuCache<int, std::string> lfu(CAPACITY);
     ArcCache<int, std::string> arc(CAPACITY);
+    UnifiedArcCache<int, std::string> unifiedArc(CAPACITY);
+    TinyLfuCache<int, std::string> tinyLfu(CAPACITY);
+    SampledLruCache<int, std::string> sampledLru(CAPACITY);
+    SampledLfuCache<int, std::string> sampledLfu(CAPACITY);
+    S3FifoCache<int, std::string> s3fifo(CAPACITY);
 
     std::random_device rd;
     std::mt19937 gen(rd());
     
-    std::array<CachePolicy<int, std::string>*, 3> caches = {&lru, &lfu, &arc};
-    std::vector<int> hits(3, 0);
-    std::vector<int> get_operations(3, 0);
+    std::array<CachePolicy<int, std::string>*, 8> caches = {&lru, &lfu, &arc, &unifiedArc, &tinyLfu, &sampledLru,
+                                                            &sampledLfu, &s3fifo};
+    std::vector<int> hits(caches.size(), 0);
+    std::vector<int> get_operations(caches.size(), 0);
 
     // 先进行一系列put操作
     for (int i = 0; i < caches.size(); ++i) {
@@ -98,10 +109,16 @@ void testLoopPattern() {
     LruCache<int, std::string> lru(CAPACITY);
     LfuCache<int, std::string> lfu(CAPACITY);
     ArcCache<int, std::string> arc(CAPACITY);
+    UnifiedArcCache<int, std::string> unifiedArc(CAPACITY);
+    TinyLfuCache<int, std::string> tinyLfu(CAPACITY);
+    SampledLruCache<int, std::string> sampledLru(CAPACITY);
+    SampledLfuCache<int, std::string> sampledLfu(CAPACITY);
+    S3FifoCache<int, std::string> s3fifo(CAPACITY);
 
-    std::array<CachePolicy<int, std::string>*, 3> caches = {&lru, &lfu, &arc};
-    std::vector<int> hits(3, 0);
-    std::vector<int> get_operations(3, 0);
+    std::array<CachePolicy<int, std::string>*, 8> caches = {&lru, &lfu, &arc, &unifiedArc, &tinyLfu, &sampledLru,
+                                                            &sampledLfu, &s3fifo};
+    std::vector<int> hits(caches.size(), 0);
+    std::vector<int> get_operations(caches.size(), 0);
 
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -147,12 +164,18 @@ void testWorkloadShift() {
     LruCache<int, std::string> lru(CAPACITY);
     LfuCache<int, std::string> lfu(CAPACITY);
     ArcCache<int, std::string> arc(CAPACITY);
+    UnifiedArcCache<int, std::string> unifiedArc(CAPACITY);
+    TinyLfuCache<int, std::string> tinyLfu(CAPACITY);
+    SampledLruCache<int, std::string> sampledLru(CAPACITY);
+    SampledLfuCache<int, std::string> sampledLfu(CAPACITY);
+    S3FifoCache<int, std::string> s3fifo(CAPACITY);
 
     std::random_device rd;
     std::mt19937 gen(rd());
-    std::array<CachePolicy<int, std::string>*, 3> caches = {&lru, &lfu, &arc};
-    std::vector<int> hits(3, 0);
-    std::vector<int> get_operations(3, 0);
+    std::array<CachePolicy<int, std::string>*, 8> caches = {&lru, &lfu, &arc, &unifiedArc, &tinyLfu, &sampledLru,
+                                                            &sampledLfu, &s3fifo};
+    std::vector<int> hits(caches.size(), 0);
+    std::vector<int> get_operations(caches.size(), 0);
 
     // 先填充一些初始数据
     for (int i = 0; i < caches.size(); ++i) {
@@ -202,9 +225,11 @@ void testWorkloadShift() {
     printResults("工作负载剧烈变化测试", CAPACITY, get_operations, hits);
 }
 int main() {
+    Timer timer;
     testHotDataAccess();
     testLoopPattern();
     testWorkloadShift();
+    std::cout << "\n总耗时: " << std::fixed << std::setprecision(1) << timer.elapsed() << " ms" << std::endl;
     return 0;
 }
 